@@ -2,10 +2,10 @@
 
 #include "LispNode.h"
 
-// Definitions of the static deletion queues
+// Definitions of the static deletion lists
 
 template<>
-CircularQueue Allocator<LispNode>::deletion_queue{};
+DeletionList Allocator<LispNode>::deletion_list{};
 
 template<>
-CircularQueue Allocator<Box>::deletion_queue{};
+DeletionList Allocator<Box>::deletion_list{};
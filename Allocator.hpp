@@ -8,87 +8,114 @@
 #include "types.h"
 #include "extra.h"
 
-#include "circular_queue.h"
+#include "deletion_list.h"
+
+#ifdef SIMPLE_ALLOCATOR
+#include "SimpleAllocator.h"
+#endif /* SIMPLE_ALLOCATOR */
 
 template<typename T>
 class Allocator {
 private:
-    static CircularQueue deletion_queue;
+    static DeletionList deletion_list;
 
 public:
+#ifdef TARGET_6502
+    constexpr static size_t DELETION_BUDGET = 2;
+#else
+    constexpr static size_t DELETION_BUDGET = 4;
+#endif /* TARGET_6502 */
+
     static void init() {
-        deletion_queue.init();
+        deletion_list.init();
     }
 
     static void *allocate(size_t size) {
         T *recycled;
 
-        if((recycled = static_cast<T *>(deletion_queue.dequeue())) != nullptr) {
+        if((recycled = static_cast<T *>(deletion_list.pop())) != nullptr) {
             recycled->~T();
 
+            // Large structures that died are deleted a few objects per allocation
+            if(deletion_list.is_long()) {
+                size_t budget = DELETION_BUDGET;
+
+                process_deletions(budget);
+            }
+
             return recycled;
         }
 
+#if defined(GENERATIONAL)
+        // Objects go straight to the old generation while the nursery is full
+        CounterType *pointer = (CounterType *) SimpleAllocator::allocate_young(size + sizeof(CounterType));
+
+        if(pointer == nullptr) {
+            pointer = (CounterType *) SimpleAllocator::allocate(size + sizeof(CounterType), AllocationIndexOf<T>::value);
+        }
+#elif defined(SIMPLE_ALLOCATOR)
+        CounterType *pointer = (CounterType *) SimpleAllocator::allocate(size + sizeof(CounterType), AllocationIndexOf<T>::value);
+#else
         CounterType *pointer = (CounterType *) Allocate(size + sizeof(CounterType));
+#endif /* SIMPLE_ALLOCATOR */
         *pointer = 0;
 
         return pointer + 1;
     }
 
     static void deallocate(void *pointer) noexcept {
+#ifdef GENERATIONAL
+        // The nursery is emptied as a whole
+        if(SimpleAllocator::is_young(pointer)) {
+            return;
+        }
+#endif /* GENERATIONAL */
+
+#ifdef SIMPLE_ALLOCATOR
+        SimpleAllocator::deallocate(((CounterType *) pointer) - 1, AllocationIndexOf<T>::value);
+#else
         Deallocate(((CounterType *) pointer) - 1);
+#endif /* SIMPLE_ALLOCATOR */
     }
 
     static void enqueue_for_deletion(T *pointer) {
-        deletion_queue.enqueue(pointer);
-
-        // If the queue overflows it looks empty
-        //
-        // This should happen only sporadically, and the reinit() function
-        // takes care that the deletion queue does not get overflown again,
-        // using iteration instead of recursion
-        if(deletion_queue.is_empty_or_overflown()) {
-            reinit();
+        // Only without memory for the list, the object is deleted right away (recursively)
+        if(!deletion_list.push(pointer)) {
+            delete pointer;
         }
     }
 
-    static bool process_deletions() {
+    // Deletes objects until the budget (discounted as they are deleted) runs out, returning whether any was deleted
+    //
+    // Deleting an object enqueues the ones it held, so the list may not be empty afterwards
+    static bool process_deletions(size_t &budget) {
         bool deleted = false;
 
-        while(!deletion_queue.is_empty_or_overflown()) {
-            T* pointer = static_cast<T*>(deletion_queue.dequeue());
+        while(budget > 0) {
+            T* pointer = static_cast<T*>(deletion_list.pop());
+
+            if(pointer == nullptr) {
+                break;
+            }
 
             delete pointer;
             deleted = true;
-        }
-
-        return deleted;
-    }
 
-private:
-    static void reinit() {
-        T **old_deletion_queue = reinterpret_cast<T**>(deletion_queue.reinit());
-
-        for(size_t current = 0; current < CircularQueue::QUEUE_SIZE; current++) {
-            delete old_deletion_queue[current];
-
-            while(process_deletions() == true) {
-                // Keep cleaning...
-            }
+            budget--;
         }
 
-        delete[] old_deletion_queue;
+        return deleted;
     }
 };
 
-// Declarations of the static deletion queues
+// Declarations of the static deletion lists
 struct LispNode;
 struct Box;
 
 template<>
-CircularQueue Allocator<LispNode>::deletion_queue;
+DeletionList Allocator<LispNode>::deletion_list;
 
 template<>
-CircularQueue Allocator<Box>::deletion_queue;
+DeletionList Allocator<Box>::deletion_list;
 
 #endif /* ALLOCATOR_HPP */
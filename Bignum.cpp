@@ -0,0 +1,672 @@
+#include "Bignum.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "extra.h"
+
+static constexpr unsigned int LIMB_BITS = sizeof(Limb) * 8;
+static constexpr unsigned int INTEGRAL_LIMBS = (sizeof(Integral) + sizeof(Limb) - 1) / sizeof(Limb);
+
+static_assert(sizeof(Integral) > sizeof(Limb), "an Integral must span more than one limb");
+
+// Largest power of ten that fits a limb, so decimal conversions go one chunk of digits at a time
+#ifdef TARGET_6502
+static constexpr Limb DECIMAL_CHUNK = 10000;
+static constexpr unsigned int DECIMAL_CHUNK_DIGITS = 4;
+#else
+static constexpr Limb DECIMAL_CHUNK = 1000000000;
+static constexpr unsigned int DECIMAL_CHUNK_DIGITS = 9;
+#endif /* TARGET_6502 */
+
+// Operands with fewer limbs than this are multiplied limb by limb (schoolbook), and larger ones
+// are split in halves, trading one of the four half-size products for a few additions (Karatsuba)
+#ifdef TARGET_6502
+static constexpr unsigned int KARATSUBA_THRESHOLD = 16;
+#else
+static constexpr unsigned int KARATSUBA_THRESHOLD = 32;
+#endif /* TARGET_6502 */
+
+// Magnitudes
+//
+// The functions below work on limb arrays, least significant limb first
+
+static unsigned int trimmed_length(const Limb *limbs, unsigned int length) {
+	while(length > 0 && limbs[length - 1] == 0) {
+		length--;
+	}
+
+	return length;
+}
+
+// Both magnitudes must be trimmed
+static int compare_magnitudes(const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length) {
+	if(first_length != second_length) {
+		return (first_length < second_length ? -1 : 1);
+	}
+
+	for(unsigned int i = first_length; i-- > 0;) {
+		if(first[i] != second[i]) {
+			return (first[i] < second[i] ? -1 : 1);
+		}
+	}
+
+	return 0;
+}
+
+// Writes one limb past the longest operand, and returns the number of limbs written
+static unsigned int add_magnitudes(Limb *result, const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length) {
+	if(first_length < second_length) {
+		const Limb *swap_limbs = first;
+		first = second;
+		second = swap_limbs;
+
+		unsigned int swap_length = first_length;
+		first_length = second_length;
+		second_length = swap_length;
+	}
+
+	DoubleLimb carry = 0;
+
+	for(unsigned int i = 0; i < first_length; i++) {
+		carry += first[i];
+
+		if(i < second_length) {
+			carry += second[i];
+		}
+
+		result[i] = static_cast<Limb>(carry);
+		carry >>= LIMB_BITS;
+	}
+
+	result[first_length] = static_cast<Limb>(carry);
+
+	return first_length + 1;
+}
+
+// The first magnitude must not be smaller than the second; the result can be the first operand itself
+static void subtract_magnitudes(Limb *result, const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length) {
+	Limb borrow = 0;
+
+	for(unsigned int i = 0; i < first_length; i++) {
+		DoubleLimb minuend = first[i];
+		DoubleLimb subtrahend = static_cast<DoubleLimb>(i < second_length ? second[i] : 0) + borrow;
+
+		result[i] = static_cast<Limb>(minuend - subtrahend);
+		borrow = (minuend < subtrahend);
+	}
+}
+
+// Adds the limbs into the result from the given offset, carrying up to the end of the result
+static void add_into(Limb *result, unsigned int result_length, const Limb *limbs, unsigned int length, unsigned int offset) {
+	DoubleLimb carry = 0;
+
+	for(unsigned int i = offset; i < result_length && (i - offset < length || carry != 0); i++) {
+		carry += result[i];
+
+		if(i - offset < length) {
+			carry += limbs[i - offset];
+		}
+
+		result[i] = static_cast<Limb>(carry);
+		carry >>= LIMB_BITS;
+	}
+}
+
+static void multiply_schoolbook(Limb *result, const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length) {
+	memset(result, 0, (first_length + second_length) * sizeof(Limb));
+
+	for(unsigned int i = 0; i < first_length; i++) {
+		DoubleLimb carry = 0;
+
+		for(unsigned int j = 0; j < second_length; j++) {
+			carry += static_cast<DoubleLimb>(first[i]) * second[j] + result[i + j];
+
+			result[i + j] = static_cast<Limb>(carry);
+			carry >>= LIMB_BITS;
+		}
+
+		result[i + second_length] = static_cast<Limb>(carry);
+	}
+}
+
+// Writes first_length + second_length limbs
+static void multiply_magnitudes(Limb *result, const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length) {
+	if(first_length < second_length) {
+		multiply_magnitudes(result, second, second_length, first, first_length);
+
+		return;
+	}
+
+	if(second_length < KARATSUBA_THRESHOLD) {
+		multiply_schoolbook(result, first, first_length, second, second_length);
+
+		return;
+	}
+
+	unsigned int result_length = first_length + second_length;
+
+	// The first operand is split as high * B^half + low
+	unsigned int half = (first_length + 1) / 2;
+	unsigned int first_high_length = first_length - half;
+
+	if(second_length <= half) {
+		// Too short to split the second operand as well: low * second + (high * second) * B^half
+		multiply_magnitudes(result, first, half, second, second_length);
+		memset(result + half + second_length, 0, (result_length - half - second_length) * sizeof(Limb));
+
+		Limb *high = new Limb[first_high_length + second_length];
+
+		multiply_magnitudes(high, first + half, first_high_length, second, second_length);
+		add_into(result, result_length, high, first_high_length + second_length, half);
+
+		delete[] high;
+
+		return;
+	}
+
+	unsigned int second_high_length = second_length - half;
+
+	// Low and high products go straight to their places in the result
+	multiply_magnitudes(result, first, half, second, half);
+	multiply_magnitudes(result + 2 * half, first + half, first_high_length, second + half, second_high_length);
+
+	// The middle term is (first_low + first_high) * (second_low + second_high) - low - high
+	Limb *first_sum = new Limb[half + 1];
+	Limb *second_sum = new Limb[half + 1];
+
+	add_magnitudes(first_sum, first, half, first + half, first_high_length);
+	add_magnitudes(second_sum, second, half, second + half, second_high_length);
+
+	unsigned int middle_length = 2 * half + 2;
+	Limb *middle = new Limb[middle_length];
+
+	multiply_magnitudes(middle, first_sum, half + 1, second_sum, half + 1);
+
+	subtract_magnitudes(middle, middle, middle_length, result, 2 * half);
+	subtract_magnitudes(middle, middle, middle_length, result + 2 * half, first_high_length + second_high_length);
+
+	add_into(result, result_length, middle, middle_length, half);
+
+	delete[] first_sum;
+	delete[] second_sum;
+	delete[] middle;
+}
+
+// Shifts left by less than a limb, and returns the bits shifted out
+static Limb shift_left(Limb *result, const Limb *limbs, unsigned int length, unsigned int shift) {
+	Limb carry = 0;
+
+	for(unsigned int i = 0; i < length; i++) {
+		DoubleLimb shifted = static_cast<DoubleLimb>(limbs[i]) << shift;
+
+		result[i] = static_cast<Limb>(shifted) | carry;
+		carry = static_cast<Limb>(shifted >> LIMB_BITS);
+	}
+
+	return carry;
+}
+
+// Long division, one limb of the quotient at a time (Knuth's algorithm D)
+//
+// The first magnitude must be at least as long as the second, which must not be zero. The quotient takes
+// first_length - second_length + 1 limbs, and the remainder second_length limbs.
+static void divide_magnitudes(const Limb *first, unsigned int first_length, const Limb *second, unsigned int second_length, Limb *quotient, Limb *remainder) {
+	if(second_length == 1) {
+		DoubleLimb rest = 0;
+
+		for(unsigned int i = first_length; i-- > 0;) {
+			rest = (rest << LIMB_BITS) | first[i];
+
+			quotient[i] = static_cast<Limb>(rest / second[0]);
+			rest %= second[0];
+		}
+
+		remainder[0] = static_cast<Limb>(rest);
+
+		return;
+	}
+
+	// Both operands are shifted so the top bit of the divisor is set, which keeps each estimate
+	// of a quotient limb at most two above the right one
+	unsigned int shift = 0;
+
+	while(((static_cast<DoubleLimb>(second[second_length - 1]) << shift) & (DoubleLimb(1) << (LIMB_BITS - 1))) == 0) {
+		shift++;
+	}
+
+	Limb *divisor = new Limb[second_length];
+	Limb *dividend = new Limb[first_length + 1];
+
+	shift_left(divisor, second, second_length, shift);
+	dividend[first_length] = shift_left(dividend, first, first_length, shift);
+
+	constexpr DoubleLimb BASE = DoubleLimb(1) << LIMB_BITS;
+
+	Limb top = divisor[second_length - 1];
+	Limb next = divisor[second_length - 2];
+
+	for(unsigned int j = first_length - second_length + 1; j-- > 0;) {
+		Limb *window = dividend + j;
+
+		DoubleLimb numerator = (static_cast<DoubleLimb>(window[second_length]) << LIMB_BITS) | window[second_length - 1];
+		DoubleLimb estimate = numerator / top;
+		DoubleLimb rest = numerator % top;
+
+		while(estimate >= BASE || estimate * next > ((rest << LIMB_BITS) | window[second_length - 2])) {
+			estimate--;
+			rest += top;
+
+			if(rest >= BASE) {
+				break;
+			}
+		}
+
+		// Subtracts estimate * divisor from the window of the dividend
+		DoubleLimb carry = 0;
+		Limb borrow = 0;
+
+		for(unsigned int i = 0; i <= second_length; i++) {
+			DoubleLimb product = carry;
+
+			if(i < second_length) {
+				product += estimate * divisor[i];
+			}
+
+			carry = product >> LIMB_BITS;
+
+			DoubleLimb current = window[i];
+			DoubleLimb subtrahend = static_cast<DoubleLimb>(static_cast<Limb>(product)) + borrow;
+
+			window[i] = static_cast<Limb>(current - subtrahend);
+			borrow = (current < subtrahend);
+		}
+
+		// The estimate was still one too large: adds the divisor back
+		if(borrow != 0) {
+			estimate--;
+
+			add_into(window, second_length + 1, divisor, second_length, 0);
+		}
+
+		quotient[j] = static_cast<Limb>(estimate);
+	}
+
+	for(unsigned int i = 0; i < second_length; i++) {
+		DoubleLimb pair = (static_cast<DoubleLimb>(dividend[i + 1]) << LIMB_BITS) | dividend[i];
+
+		remainder[i] = static_cast<Limb>(pair >> shift);
+	}
+
+	delete[] divisor;
+	delete[] dividend;
+}
+
+// Bignums
+
+Bignum::Bignum(unsigned int capacity, bool negative): length{0}, negative{negative} {
+	limbs = new Limb[capacity > 0 ? capacity : 1];
+}
+
+Bignum::Bignum(Integral value): length{0}, negative{value < 0} {
+	limbs = new Limb[INTEGRAL_LIMBS];
+
+	UnsignedIntegral magnitude = static_cast<UnsignedIntegral>(value);
+
+	if(negative) {
+		magnitude = 0 - magnitude;
+	}
+
+	while(magnitude != 0) {
+		limbs[length++] = static_cast<Limb>(magnitude);
+		magnitude >>= LIMB_BITS;
+	}
+}
+
+Bignum::Bignum(const Bignum &other): length{other.length}, negative{other.negative} {
+	limbs = new Limb[length > 0 ? length : 1];
+
+	memcpy(limbs, other.limbs, length * sizeof(Limb));
+}
+
+Bignum::~Bignum() {
+	delete[] limbs;
+}
+
+void Bignum::trim() {
+	length = trimmed_length(limbs, length);
+
+	if(length == 0) {
+		negative = false;
+	}
+}
+
+Bignum *Bignum::parse(const char *digits) {
+	bool negative = (*digits == '-');
+
+	if(*digits == '-' || *digits == '+') {
+		digits++;
+	}
+
+	unsigned int number_digits = 0;
+
+	while(isdigit(digits[number_digits])) {
+		number_digits++;
+	}
+
+	if(number_digits == 0) {
+		return nullptr;
+	}
+
+	// A limb holds at least one chunk of digits
+	Bignum *result = new Bignum(number_digits / DECIMAL_CHUNK_DIGITS + 1, negative);
+
+	unsigned int position = 0;
+
+	while(position < number_digits) {
+		// The first chunk takes the digits left over, so all the others are full
+		unsigned int chunk_digits = DECIMAL_CHUNK_DIGITS;
+
+		if(position == 0 && number_digits % DECIMAL_CHUNK_DIGITS != 0) {
+			chunk_digits = number_digits % DECIMAL_CHUNK_DIGITS;
+		}
+
+		Limb chunk = 0;
+		Limb scale = 1;
+
+		for(unsigned int i = 0; i < chunk_digits; i++) {
+			chunk = (chunk * 10) + (digits[position++] - '0');
+			scale *= 10;
+		}
+
+		// result = (result * scale) + chunk
+		DoubleLimb carry = chunk;
+
+		for(unsigned int i = 0; i < result->length; i++) {
+			carry += static_cast<DoubleLimb>(result->limbs[i]) * scale;
+
+			result->limbs[i] = static_cast<Limb>(carry);
+			carry >>= LIMB_BITS;
+		}
+
+		if(carry != 0) {
+			result->limbs[result->length++] = static_cast<Limb>(carry);
+		}
+	}
+
+	result->trim();
+
+	return result;
+}
+
+bool Bignum::fits_integral() const {
+	if(length > INTEGRAL_LIMBS) {
+		return false;
+	}
+
+	UnsignedIntegral magnitude = 0;
+
+	for(unsigned int i = length; i-- > 0;) {
+		magnitude = (magnitude << LIMB_BITS) | limbs[i];
+	}
+
+	// The most negative value has no positive counterpart
+	return (magnitude <= static_cast<UnsignedIntegral>(INTEGRAL_MAXIMUM) + (negative ? 1 : 0));
+}
+
+Integral Bignum::get_integral() const {
+	UnsignedIntegral magnitude = 0;
+
+	for(unsigned int i = length; i-- > 0;) {
+		magnitude = (magnitude << LIMB_BITS) | limbs[i];
+	}
+
+	return static_cast<Integral>(negative ? 0 - magnitude : magnitude);
+}
+
+Real Bignum::get_real() const {
+	Real base = static_cast<Integral>(DoubleLimb(1) << LIMB_BITS);
+	Real result = Real(0.0);
+
+	for(unsigned int i = length; i-- > 0;) {
+		Real limb = static_cast<Integral>(limbs[i]);
+
+		result = (result * base) + limb;
+	}
+
+	return (negative ? Real(0.0) - result : result);
+}
+
+char *Bignum::get_string() const {
+	// Each limb takes less than LIMB_BITS / 3 decimal digits
+	unsigned int maximum_digits = (length * LIMB_BITS) / 3 + 1;
+
+	char *buffer = static_cast<char *>(Allocate(maximum_digits + 2));
+
+	// Chunks of digits come out from the least significant one, as remainders of repeated divisions
+	Limb *work = new Limb[length > 0 ? length : 1];
+	Limb *chunks = new Limb[maximum_digits / DECIMAL_CHUNK_DIGITS + 1];
+
+	memcpy(work, limbs, length * sizeof(Limb));
+
+	unsigned int work_length = length;
+	unsigned int number_chunks = 0;
+
+	while(work_length > 0) {
+		DoubleLimb rest = 0;
+
+		for(unsigned int i = work_length; i-- > 0;) {
+			rest = (rest << LIMB_BITS) | work[i];
+
+			work[i] = static_cast<Limb>(rest / DECIMAL_CHUNK);
+			rest %= DECIMAL_CHUNK;
+		}
+
+		chunks[number_chunks++] = static_cast<Limb>(rest);
+		work_length = trimmed_length(work, work_length);
+	}
+
+	unsigned int position = 0;
+
+	if(negative) {
+		buffer[position++] = '-';
+	}
+
+	if(number_chunks == 0) {
+		buffer[position++] = '0';
+	}
+
+	for(unsigned int i = number_chunks; i-- > 0;) {
+		char digits[DECIMAL_CHUNK_DIGITS];
+		Limb chunk = chunks[i];
+
+		for(unsigned int j = DECIMAL_CHUNK_DIGITS; j-- > 0;) {
+			digits[j] = '0' + (chunk % 10);
+			chunk /= 10;
+		}
+
+		unsigned int first_digit = 0;
+
+		// Only the most significant chunk goes without its leading zeros
+		if(i == number_chunks - 1) {
+			while(first_digit < DECIMAL_CHUNK_DIGITS - 1 && digits[first_digit] == '0') {
+				first_digit++;
+			}
+		}
+
+		for(unsigned int j = first_digit; j < DECIMAL_CHUNK_DIGITS; j++) {
+			buffer[position++] = digits[j];
+		}
+	}
+
+	buffer[position] = '\0';
+
+	delete[] work;
+	delete[] chunks;
+
+	return buffer;
+}
+
+int Bignum::compare(const Bignum &first, const Bignum &second) {
+	if(first.negative != second.negative) {
+		return (first.negative ? -1 : 1);
+	}
+
+	int comparison = compare_magnitudes(first.limbs, first.length, second.limbs, second.length);
+
+	return (first.negative ? -comparison : comparison);
+}
+
+// Adds the first bignum to the second one taken with the given sign
+Bignum *Bignum::add_signed(const Bignum &first, const Bignum &second, bool second_negative) {
+	if(first.negative == second_negative) {
+		Bignum *result = new Bignum((first.length > second.length ? first.length : second.length) + 1, first.negative);
+
+		result->length = add_magnitudes(result->limbs, first.limbs, first.length, second.limbs, second.length);
+		result->trim();
+
+		return result;
+	}
+
+	// Signs differ: the smaller magnitude is taken from the larger one, whose sign the result keeps
+	bool first_larger = (compare_magnitudes(first.limbs, first.length, second.limbs, second.length) >= 0);
+
+	const Bignum &larger = (first_larger ? first : second);
+	const Bignum &smaller = (first_larger ? second : first);
+
+	Bignum *result = new Bignum(larger.length, first_larger ? first.negative : second_negative);
+
+	subtract_magnitudes(result->limbs, larger.limbs, larger.length, smaller.limbs, smaller.length);
+
+	result->length = larger.length;
+	result->trim();
+
+	return result;
+}
+
+Bignum *Bignum::add(const Bignum &first, const Bignum &second) {
+	return add_signed(first, second, second.negative);
+}
+
+Bignum *Bignum::subtract(const Bignum &first, const Bignum &second) {
+	return add_signed(first, second, !second.negative);
+}
+
+Bignum *Bignum::multiply(const Bignum &first, const Bignum &second) {
+	Bignum *result = new Bignum(first.length + second.length, first.negative != second.negative);
+
+	if(first.is_zero() || second.is_zero()) {
+		result->negative = false;
+
+		return result;
+	}
+
+	multiply_magnitudes(result->limbs, first.limbs, first.length, second.limbs, second.length);
+
+	result->length = first.length + second.length;
+	result->trim();
+
+	return result;
+}
+
+Bignum *Bignum::shift(const Bignum &value, Integral amount) {
+	if(amount >= 0) {
+		unsigned int limb_shift = amount / LIMB_BITS;
+		unsigned int bit_shift = amount % LIMB_BITS;
+
+		Bignum *result = new Bignum(value.length + limb_shift + 1, value.negative);
+
+		memset(result->limbs, 0, limb_shift * sizeof(Limb));
+		result->limbs[value.length + limb_shift] = shift_left(result->limbs + limb_shift, value.limbs, value.length, bit_shift);
+
+		result->length = value.length + limb_shift + 1;
+		result->trim();
+
+		return result;
+	}
+
+	UnsignedIntegral distance = 0 - static_cast<UnsignedIntegral>(amount);
+
+	if(distance / LIMB_BITS >= value.length) {
+		return new Bignum(Integral(value.negative ? -1 : 0));
+	}
+
+	unsigned int limb_shift = distance / LIMB_BITS;
+	unsigned int bit_shift = distance % LIMB_BITS;
+
+	// Whether any bit set is shifted out
+	bool inexact = ((value.limbs[limb_shift] & ((DoubleLimb(1) << bit_shift) - 1)) != 0);
+
+	for(unsigned int i = 0; i < limb_shift; i++) {
+		inexact = inexact || (value.limbs[i] != 0);
+	}
+
+	Bignum *result = new Bignum(value.length - limb_shift, value.negative);
+
+	for(unsigned int i = 0; i < value.length - limb_shift; i++) {
+		DoubleLimb pair = value.limbs[i + limb_shift];
+
+		if(i + limb_shift + 1 < value.length) {
+			pair |= static_cast<DoubleLimb>(value.limbs[i + limb_shift + 1]) << LIMB_BITS;
+		}
+
+		result->limbs[i] = static_cast<Limb>(pair >> bit_shift);
+	}
+
+	result->length = value.length - limb_shift;
+	result->trim();
+
+	// Negative values round down, as they would with two's complement
+	if(value.negative && inexact) {
+		Bignum *rounded = subtract(*result, Bignum(Integral(1)));
+
+		delete result;
+
+		return rounded;
+	}
+
+	return result;
+}
+
+unsigned long Bignum::get_bit_count() const {
+	unsigned long count = 0;
+
+	for(unsigned int i = 0; i < length; i++) {
+		for(Limb limb = limbs[i]; limb != 0; limb &= (limb - 1)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+Bignum *Bignum::divide(const Bignum &first, const Bignum &second, Bignum **remainder) {
+	if(compare_magnitudes(first.limbs, first.length, second.limbs, second.length) < 0) {
+		if(remainder != nullptr) {
+			*remainder = new Bignum(first);
+		}
+
+		return new Bignum(Integral(0));
+	}
+
+	Bignum *quotient = new Bignum(first.length - second.length + 1, first.negative != second.negative);
+	Bignum *rest = new Bignum(second.length, first.negative);
+
+	divide_magnitudes(first.limbs, first.length, second.limbs, second.length, quotient->limbs, rest->limbs);
+
+	quotient->length = first.length - second.length + 1;
+	quotient->trim();
+
+	rest->length = second.length;
+	rest->trim();
+
+	if(remainder != nullptr) {
+		*remainder = rest;
+	}
+	else {
+		delete rest;
+	}
+
+	return quotient;
+}
@@ -0,0 +1,68 @@
+#ifndef BIGNUM_H
+#define BIGNUM_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+// Arbitrary-precision integers, for the results that do not fit an Integral
+//
+// The magnitude is kept in limbs, least significant first, with no leading zero limbs,
+// and the sign apart from it. Operations return new bignums and never change their operands.
+
+#ifdef TARGET_6502
+using Limb = uint16_t;
+using DoubleLimb = uint32_t;
+#else
+using Limb = uint32_t;
+using DoubleLimb = uint64_t;
+#endif /* TARGET_6502 */
+
+struct Bignum {
+	Limb *limbs;
+	unsigned int length;
+
+	bool negative;
+
+	// Room for the given number of limbs, to be filled in by the caller
+	Bignum(unsigned int capacity, bool negative);
+	Bignum(Integral value);
+	Bignum(const Bignum &other);
+	~Bignum();
+
+	// Returns nullptr if there are no digits
+	static Bignum *parse(const char *digits);
+
+	bool is_zero() const {
+		return (length == 0);
+	}
+
+	bool fits_integral() const;
+	Integral get_integral() const;
+	Real get_real() const;
+
+	// Decimal digits (with the sign), allocated with Allocate
+	char *get_string() const;
+
+	static int compare(const Bignum &first, const Bignum &second);
+
+	static Bignum *add(const Bignum &first, const Bignum &second);
+	static Bignum *subtract(const Bignum &first, const Bignum &second);
+	static Bignum *multiply(const Bignum &first, const Bignum &second);
+
+	// Truncates towards zero; the remainder (if asked for) has the sign of the dividend
+	static Bignum *divide(const Bignum &first, const Bignum &second, Bignum **remainder = nullptr);
+
+	// Shifts left by positive amounts, and right by negative ones (rounding towards negative infinity)
+	static Bignum *shift(const Bignum &value, Integral amount);
+
+	// Number of bits set in the magnitude
+	unsigned long get_bit_count() const;
+
+private:
+	static Bignum *add_signed(const Bignum &first, const Bignum &second, bool second_negative);
+
+	void trim();
+};
+
+#endif /* BIGNUM_H */
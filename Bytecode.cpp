@@ -0,0 +1,59 @@
+#include "Bytecode.h"
+
+#ifdef TARGET_6502
+static constexpr unsigned int INITIAL_CAPACITY = 16;
+#else
+static constexpr unsigned int INITIAL_CAPACITY = 64;
+#endif /* TARGET_6502 */
+
+Bytecode::Bytecode(const LispNodeRC &parameters): length{0}, capacity{INITIAL_CAPACITY}, number_constants{0}, constants_capacity{INITIAL_CAPACITY}, parameters{parameters}, number_parameters{0}, packed_dot{false}, environment_mode{false}, maximum_stack{0} {
+	instructions = new uint16_t[capacity];
+	constants = new LispNodeRC[constants_capacity];
+}
+
+Bytecode::~Bytecode() {
+	delete[] instructions;
+	delete[] constants;
+}
+
+unsigned int Bytecode::emit(uint16_t word) {
+	if(length == capacity) {
+		uint16_t *new_instructions = new uint16_t[capacity * 2];
+
+		memcpy(new_instructions, instructions, length * sizeof(uint16_t));
+		delete[] instructions;
+
+		instructions = new_instructions;
+		capacity *= 2;
+	}
+
+	instructions[length] = word;
+
+	// Returns the position of the word, so jump targets can be patched later
+	return length++;
+}
+
+uint16_t Bytecode::add_constant(const LispNodeRC &constant) {
+	for(unsigned int i = 0; i < number_constants; i++) {
+		if(constants[i].get_pointer() == constant.get_pointer()) {
+			return i;
+		}
+	}
+
+	if(number_constants == constants_capacity) {
+		LispNodeRC *new_constants = new LispNodeRC[constants_capacity * 2];
+
+		for(unsigned int i = 0; i < number_constants; i++) {
+			new_constants[i] = constants[i];
+		}
+
+		delete[] constants;
+
+		constants = new_constants;
+		constants_capacity *= 2;
+	}
+
+	constants[number_constants] = constant;
+
+	return number_constants++;
+}
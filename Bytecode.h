@@ -0,0 +1,59 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+
+#include "LispNode.h"
+
+// Instructions of a compiled closure body: each opcode is followed by its operands, one word each
+
+enum BytecodeOperation : uint16_t {
+	BC_CONSTANT,         // <constant>: pushes the constant
+	BC_LOCAL,            // <slot>: pushes a parameter kept in the data stack
+	BC_ENVIRONMENT,      // <constant>: pushes the value of a local atom in the environment
+	BC_LOOKUP,           // <constant>: pushes the value of a symbol (environment, then value cell)
+	BC_SET_LOCAL,        // <slot> <constant>: pops into a parameter kept in the data stack, pushes '()
+	BC_SET,              // <constant>: pops into the binding of a symbol, pushes '()
+	BC_POP,
+	BC_SLIDE,            // <count>: drops <count> entries under the top one
+	BC_JUMP,             // <target>
+	BC_JUMP_UNLESS_TRUE, // <target>: pops the test, jumps unless it is #t
+	BC_AND,              // <target>: jumps keeping #f on the stack, otherwise pops
+	BC_OR,               // <target>: jumps keeping #t on the stack, otherwise pops
+	BC_CLOSURE,          // <constant>: pushes a closure of the lambda in the constant
+	BC_OPERATOR,         // <operator> <arity> <constant>: applies a predefined operator to the arguments
+	BC_CHECK_CALLEE,     // <constant> <target> <constant>: hands the expression (and the let bindings in scope) to the tree-walking VM if the callee is not a procedure
+	BC_CALL,             // <arity> <constant>
+	BC_TAIL_CALL,        // <arity> <constant>
+	BC_RETURN
+};
+
+struct Bytecode {
+	uint16_t *instructions;
+	unsigned int length;
+	unsigned int capacity;
+
+	LispNodeRC *constants;
+	unsigned int number_constants;
+	unsigned int constants_capacity;
+
+	// Parameter list of the lambda, and number of names bound by it
+	LispNodeRC parameters;
+	unsigned int number_parameters;
+	bool packed_dot;
+
+	// If set, parameters are bound in the environment (to be captured by nested closures)
+	// instead of being kept in data stack slots
+	bool environment_mode;
+
+	// Data stack entries used by a call, counting the parameter slots
+	unsigned int maximum_stack;
+
+	Bytecode(const LispNodeRC &parameters);
+	~Bytecode();
+
+	unsigned int emit(uint16_t word);
+	uint16_t add_constant(const LispNodeRC &constant);
+};
+
+#endif /* BYTECODE_H */
@@ -0,0 +1,416 @@
+#include "CycleCollector.h"
+
+#include "Bytecode.h"
+
+#ifdef HASH_TABLES
+#include "HashMap.h"
+#endif /* HASH_TABLES */
+
+#include "extra.h"
+
+#ifdef TARGET_6502
+static constexpr unsigned int INITIAL_CAPACITY = 32;
+#else
+static constexpr unsigned int INITIAL_CAPACITY = 1024;
+#endif /* TARGET_6502 */
+
+// Objects found by collect() are either nodes or boxes
+
+struct Entry {
+	void *object;
+	bool box;
+};
+
+struct EntryArray {
+	Entry *entries;
+
+	unsigned int capacity;
+	unsigned int count;
+
+	bool push(Entry entry) {
+		if(count == capacity) {
+			unsigned int new_capacity = (capacity == 0 ? INITIAL_CAPACITY : capacity * 2);
+			Entry *new_entries = (Entry *) Allocate(new_capacity * sizeof(Entry));
+
+			if(new_entries == nullptr) {
+				return false;
+			}
+
+			for(unsigned int i = 0; i < count; i++) {
+				new_entries[i] = entries[i];
+			}
+
+			Deallocate(entries);
+
+			entries = new_entries;
+			capacity = new_capacity;
+		}
+
+		entries[count++] = entry;
+
+		return true;
+	}
+
+	void clear() {
+		Deallocate(entries);
+
+		entries = nullptr;
+		capacity = 0;
+		count = 0;
+	}
+};
+
+unsigned int CycleCollector::number_candidates = 0;
+
+// Candidates are kept by their address, with open addressing and linear probing (capacity is always
+// a power of two, and empty slots have no object), so any of them can be taken back in constant time
+static Entry *candidates;
+static unsigned int candidates_capacity;
+
+// Objects whose children are still to be visited, and the white objects found
+static EntryArray pending;
+static EntryArray garbage;
+
+static CounterType &counter(Entry entry) {
+	return *(reinterpret_cast<CounterType *>(entry.object) - 1);
+}
+
+static CounterType get_count(Entry entry) {
+	return (counter(entry) & CycleCollector::COUNT_MASK);
+}
+
+static CounterType get_color(Entry entry) {
+	return (counter(entry) & CycleCollector::COLOR_MASK);
+}
+
+static void set_color(Entry entry, CounterType color) {
+	counter(entry) = (counter(entry) & ~CycleCollector::COLOR_MASK) | color;
+}
+
+// Calls visit for each reference the object holds (none, for pure atoms and locals)
+template<typename Visitor>
+static void for_each_child(Entry entry, Visitor visit) {
+	auto visit_node = [&](LispNode *node) {
+		if(node != nullptr && !LispNode::is_immortal(node)) {
+			visit(Entry{node, false});
+		}
+	};
+
+	auto visit_box = [&](Box *box) {
+		if(box != nullptr) {
+			visit(Entry{box, true});
+		}
+	};
+
+	if(entry.box) {
+		Box *box = static_cast<Box *>(entry.object);
+
+		visit_node(box->item.get_pointer());
+		visit_box(box->get_next_pointer());
+
+		return;
+	}
+
+	LispNode *node = static_cast<LispNode *>(entry.object);
+
+	switch(node->type) {
+		case LispType::List:
+			visit_box(node->get_head_pointer());
+			break;
+		case LispType::AtomCode:
+			visit_node(node->code->parameters.get_pointer());
+
+			for(unsigned int i = 0; i < node->code->number_constants; i++) {
+				visit_node(node->code->constants[i].get_pointer());
+			}
+
+			break;
+#ifdef VECTORS
+		case LispType::AtomVector:
+			for(unsigned int i = 0; i < node->vector->length; i++) {
+				visit_node(node->vector->items[i].get_pointer());
+			}
+
+			break;
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case LispType::AtomHashMap:
+			for(unsigned int i = 0; i < node->hash_map->capacity; i++) {
+				visit_node(node->hash_map->keys[i].get_pointer());
+				visit_node(node->hash_map->values[i].get_pointer());
+			}
+
+			break;
+#endif /* HASH_TABLES */
+		default:
+			break;
+	}
+}
+
+// Visits the entry later, or right away (recursing) if there is no memory to keep it
+static void defer(Entry entry, void (*visit)(Entry)) {
+	if(!pending.push(entry)) {
+		visit(entry);
+	}
+}
+
+static void run(Entry entry, void (*visit)(Entry)) {
+	unsigned int base = pending.count;
+
+	defer(entry, visit);
+
+	while(pending.count > base) {
+		visit(pending.entries[--pending.count]);
+	}
+}
+
+// Subtracts the references held by everything reachable
+static void mark_gray(Entry entry) {
+	if(get_color(entry) == CycleCollector::COLOR_GRAY) {
+		return;
+	}
+
+	set_color(entry, CycleCollector::COLOR_GRAY);
+
+	for_each_child(entry, [](Entry child) {
+		counter(child)--;
+		defer(child, mark_gray);
+	});
+}
+
+// Gives back the references held by an object still in use (already made black)
+static void scan_black(Entry entry) {
+	for_each_child(entry, [](Entry child) {
+		counter(child)++;
+
+		if(get_color(child) != CycleCollector::COLOR_BLACK) {
+			set_color(child, CycleCollector::COLOR_BLACK);
+			defer(child, scan_black);
+		}
+	});
+}
+
+// Objects still referenced are in use, with everything they reach; the rest are white
+static void scan(Entry entry) {
+	if(get_color(entry) != CycleCollector::COLOR_GRAY) {
+		return;
+	}
+
+	if(get_count(entry) > 0) {
+		set_color(entry, CycleCollector::COLOR_BLACK);
+		run(entry, scan_black);
+
+		return;
+	}
+
+	set_color(entry, CycleCollector::COLOR_WHITE);
+
+	for_each_child(entry, [](Entry child) {
+		defer(child, scan);
+	});
+}
+
+static bool out_of_memory;
+
+// Gathers the white objects, flagging them as buffered so each is gathered once
+static void collect_white(Entry entry) {
+	if((counter(entry) & CycleCollector::BUFFERED) || get_color(entry) != CycleCollector::COLOR_WHITE) {
+		return;
+	}
+
+	if(!garbage.push(entry)) {
+		out_of_memory = true;
+		return;
+	}
+
+	counter(entry) |= CycleCollector::BUFFERED;
+
+	for_each_child(entry, [](Entry child) {
+		defer(child, collect_white);
+	});
+}
+
+static bool is_garbage(Entry entry) {
+	return ((counter(entry) & (CycleCollector::BUFFERED | CycleCollector::COLOR_MASK)) == (CycleCollector::BUFFERED | CycleCollector::COLOR_WHITE));
+}
+
+static unsigned int home_slot(void *object, unsigned int capacity) {
+	return ((reinterpret_cast<uintptr_t>(object) / sizeof(void *)) * 2654435761u) & (capacity - 1);
+}
+
+static unsigned int find_slot(Entry *slots, unsigned int capacity, void *object) {
+	unsigned int position = home_slot(object, capacity);
+
+	while(slots[position].object != nullptr && slots[position].object != object) {
+		position = (position + 1) & (capacity - 1);
+	}
+
+	return position;
+}
+
+static bool grow() {
+	unsigned int new_capacity = (candidates_capacity == 0 ? INITIAL_CAPACITY : candidates_capacity * 2);
+	Entry *new_candidates = (Entry *) Allocate(new_capacity * sizeof(Entry));
+
+	if(new_candidates == nullptr) {
+		return false;
+	}
+
+	for(unsigned int i = 0; i < new_capacity; i++) {
+		new_candidates[i].object = nullptr;
+	}
+
+	for(unsigned int i = 0; i < candidates_capacity; i++) {
+		if(candidates[i].object != nullptr) {
+			new_candidates[find_slot(new_candidates, new_capacity, candidates[i].object)] = candidates[i];
+		}
+	}
+
+	Deallocate(candidates);
+
+	candidates = new_candidates;
+	candidates_capacity = new_capacity;
+
+	return true;
+}
+
+static void add(Entry entry) {
+	// Keep the load factor under 3/4 so probe sequences stay short
+	if(4 * (CycleCollector::number_candidates + 1) >= 3 * candidates_capacity && !grow()) {
+		return;
+	}
+
+	candidates[find_slot(candidates, candidates_capacity, entry.object)] = entry;
+
+	counter(entry) |= CycleCollector::BUFFERED;
+	CycleCollector::number_candidates++;
+}
+
+void CycleCollector::add_candidate(LispNode *node) {
+	add(Entry{node, false});
+}
+
+void CycleCollector::add_candidate(Box *box) {
+	add(Entry{box, true});
+}
+
+bool CycleCollector::remove_candidate(void *object) {
+	if(candidates_capacity == 0) {
+		return false;
+	}
+
+	unsigned int hole = find_slot(candidates, candidates_capacity, object);
+
+	if(candidates[hole].object == nullptr) {
+		return false;
+	}
+
+	counter(candidates[hole]) &= ~BUFFERED;
+
+	candidates[hole].object = nullptr;
+	number_candidates--;
+
+	// Moves back the entries after the hole that probed past it, so no tombstones are needed
+	for(unsigned int position = (hole + 1) & (candidates_capacity - 1); candidates[position].object != nullptr; position = (position + 1) & (candidates_capacity - 1)) {
+		unsigned int home = home_slot(candidates[position].object, candidates_capacity);
+
+		if(((position - home) & (candidates_capacity - 1)) >= ((position - hole) & (candidates_capacity - 1))) {
+			candidates[hole] = candidates[position];
+			candidates[position].object = nullptr;
+
+			hole = position;
+		}
+	}
+
+	return true;
+}
+
+void CycleCollector::collect() {
+	// The candidates are packed at the start of their table, which becomes the roots (candidates
+	// found while freeing are left for the next collection)
+	EntryArray roots{candidates, candidates_capacity, 0};
+
+	for(unsigned int i = 0; i < candidates_capacity; i++) {
+		if(candidates[i].object != nullptr) {
+			counter(candidates[i]) &= ~BUFFERED;
+
+			roots.entries[roots.count++] = candidates[i];
+		}
+	}
+
+	candidates = nullptr;
+	candidates_capacity = 0;
+	number_candidates = 0;
+
+	out_of_memory = false;
+
+	// Candidates are taken back as soon as their counter reaches zero, so every root is still referenced
+	for(unsigned int i = 0; i < roots.count; i++) {
+		run(roots.entries[i], mark_gray);
+	}
+
+	for(unsigned int i = 0; i < roots.count; i++) {
+		if(get_color(roots.entries[i]) == COLOR_GRAY) {
+			run(roots.entries[i], scan);
+		}
+	}
+
+	for(unsigned int i = 0; i < roots.count; i++) {
+		if(get_color(roots.entries[i]) == COLOR_WHITE) {
+			run(roots.entries[i], collect_white);
+		}
+	}
+
+	if(out_of_memory) {
+		// Keeps every white object (making it black, and giving back its references)
+		for(unsigned int i = 0; i < garbage.count; i++) {
+			counter(garbage.entries[i]) &= ~BUFFERED;
+		}
+
+		for(unsigned int i = 0; i < roots.count; i++) {
+			if(get_color(roots.entries[i]) == COLOR_WHITE) {
+				set_color(roots.entries[i], COLOR_BLACK);
+				run(roots.entries[i], scan_black);
+			}
+		}
+
+		garbage.count = 0;
+	}
+
+	// References from the garbage to objects in use are given back, as the destructors take them
+	for(unsigned int i = 0; i < garbage.count; i++) {
+		for_each_child(garbage.entries[i], [](Entry child) {
+			if(!is_garbage(child)) {
+				counter(child)++;
+			}
+		});
+	}
+
+	// Counters of the garbage are set so that their destructors never take them to zero
+	for(unsigned int i = 0; i < garbage.count; i++) {
+		counter(garbage.entries[i]) = BUFFERED | COLOR_WHITE | (COUNT_MASK >> 1);
+	}
+
+	roots.clear();
+
+	for(unsigned int i = 0; i < garbage.count; i++) {
+		if(garbage.entries[i].box) {
+			static_cast<Box *>(garbage.entries[i].object)->~Box();
+		}
+		else {
+			static_cast<LispNode *>(garbage.entries[i].object)->~LispNode();
+		}
+	}
+
+	for(unsigned int i = 0; i < garbage.count; i++) {
+		if(garbage.entries[i].box) {
+			Allocator<Box>::deallocate(garbage.entries[i].object);
+		}
+		else {
+			Allocator<LispNode>::deallocate(garbage.entries[i].object);
+		}
+	}
+
+	garbage.clear();
+	pending.clear();
+}
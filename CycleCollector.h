@@ -0,0 +1,55 @@
+#ifndef CYCLE_COLLECTOR_H
+#define CYCLE_COLLECTOR_H
+
+#include "LispNode.h"
+
+#ifndef REFERENCE_COUNTING
+#error "CYCLE_COLLECTOR is for builds with REFERENCE_COUNTING"
+#endif /* REFERENCE_COUNTING */
+
+// Synchronous cycle collection (trial deletion, as in Bacon and Rajan) for reference counting
+//
+// Lists, boxes, code, vectors and hash maps whose counter is decremented to nonzero may be the
+// last way into a cycle, so they are kept as candidates. collect() subtracts the references among
+// everything reachable from the candidates: what is left with no references is only referenced by
+// itself, and is freed. Pure atoms are always referenced by the symbol table, so the search stops
+// at them (and at locals, which only reference pure atoms). Traversals keep their pending objects in
+// a heap array instead of recursing, so deep structures do not exhaust the hardware stack.
+
+struct CycleCollector {
+	// The highest bits of each reference counter keep the color used by collect(), and whether the
+	// object is a candidate; the counter itself uses the bits below them
+	static constexpr CounterType COLOR_BLACK = 0;
+	static constexpr CounterType COLOR_GRAY = static_cast<CounterType>(1) << (sizeof(CounterType) * 8 - 2);
+	static constexpr CounterType COLOR_WHITE = static_cast<CounterType>(2) << (sizeof(CounterType) * 8 - 2);
+	static constexpr CounterType COLOR_MASK = static_cast<CounterType>(3) << (sizeof(CounterType) * 8 - 2);
+
+	static constexpr CounterType BUFFERED = static_cast<CounterType>(1) << (sizeof(CounterType) * 8 - 3);
+	static constexpr CounterType COUNT_MASK = BUFFERED - 1;
+
+	// Candidates that make the next collection due (a fixed number, so the structures reached from
+	// the candidates never put it off)
+#ifdef TARGET_6502
+	static constexpr unsigned int THRESHOLD = 64;
+#else
+	static constexpr unsigned int THRESHOLD = 4096;
+#endif /* TARGET_6502 */
+
+	static unsigned int number_candidates;
+
+	static bool is_due() {
+		return (number_candidates >= THRESHOLD);
+	}
+
+	static void add_candidate(LispNode *node);
+	static void add_candidate(Box *box);
+
+	// Takes the object back from the candidates when its counter reaches zero, so it is freed as usual
+	// (instead of holding everything it references until the next collection)
+	static bool remove_candidate(void *object);
+
+	// Only safe where every reference in use is counted (between VM operations)
+	static void collect();
+};
+
+#endif /* CYCLE_COLLECTOR_H */
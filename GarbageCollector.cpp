@@ -0,0 +1,351 @@
+#include "GarbageCollector.h"
+
+#include "SymbolTable.h"
+#include "Bytecode.h"
+
+#ifdef HASH_TABLES
+#include "HashMap.h"
+#endif /* HASH_TABLES */
+
+#include "extra.h"
+
+#ifdef TARGET_6502
+static constexpr unsigned long MINIMUM_THRESHOLD = 256;
+static constexpr unsigned int INITIAL_MARK_CAPACITY = 32;
+#else
+static constexpr unsigned long MINIMUM_THRESHOLD = 16384;
+static constexpr unsigned int INITIAL_MARK_CAPACITY = 1024;
+#endif /* TARGET_6502 */
+
+unsigned long GarbageCollector::threshold = MINIMUM_THRESHOLD;
+
+// Nodes already marked, whose contents are still to be marked
+static LispNode **pending;
+
+static unsigned int pending_capacity;
+static unsigned int pending_count;
+
+static bool out_of_memory;
+
+#ifdef GENERATIONAL
+// Young collections take every old object as live, and only copy the nursery survivors
+static bool young_only;
+
+// Old nodes with slots outside nodes and boxes, and nursery nodes holding memory outside the heap
+static LispNode **old_containers;
+
+static unsigned int old_containers_capacity;
+static unsigned int old_containers_count;
+
+// Set if an old container could not be recorded (the next collection is then a full one)
+static bool old_containers_lost;
+
+static LispNode **young_owners;
+
+static unsigned int young_owners_capacity;
+static unsigned int young_owners_count;
+
+// Nursery objects copied to the old generation keep the new address in place of their contents
+static constexpr CounterType FORWARDED = 1;
+#endif /* GENERATIONAL */
+
+static bool push(LispNode **&array, unsigned int &capacity, unsigned int &count, LispNode *node) {
+	if(count == capacity) {
+		unsigned int new_capacity = (capacity == 0 ? INITIAL_MARK_CAPACITY : capacity * 2);
+		LispNode **new_array = (LispNode **) Allocate(new_capacity * sizeof(LispNode *));
+
+		if(new_array == nullptr) {
+			return false;
+		}
+
+		for(unsigned int i = 0; i < count; i++) {
+			new_array[i] = array[i];
+		}
+
+		Deallocate(array);
+
+		array = new_array;
+		capacity = new_capacity;
+	}
+
+	array[count++] = node;
+
+	return true;
+}
+
+static void scan(LispNode *node);
+
+static void push_pending(LispNode *node) {
+	if(!push(pending, pending_capacity, pending_count, node)) {
+#ifdef GENERATIONAL
+		// Nodes copied out of the nursery must be scanned before it is reused, so recurse instead
+		scan(node);
+#else
+		out_of_memory = true;
+#endif /* GENERATIONAL */
+	}
+}
+
+#ifdef GENERATIONAL
+static bool is_container(LispNode *node) {
+	return (node->type == LispType::AtomPure || node->type == LispType::AtomLocal || node->type == LispType::AtomCode || node->type == LispType::AtomVector || node->type == LispType::AtomHashMap);
+}
+
+static bool is_forwarded(void *object) {
+	return (*(reinterpret_cast<CounterType *>(object) - 1) == FORWARDED);
+}
+
+// Copies a nursery object to the old generation (once), returning its new address
+template<typename T>
+static T *forward(T *object, bool &copied) {
+	copied = !is_forwarded(object);
+
+	if(copied) {
+		CounterType *memory = (CounterType *) SimpleAllocator::allocate(sizeof(T) + sizeof(CounterType), AllocationIndexOf<T>::value);
+
+		// The nursery cannot be reused while a survivor is still in it
+		if(memory == nullptr) {
+			fputs("Old generation full; build with a larger OLD_GENERATION_SIZE\n", stdout);
+			exit(EXIT_FAILURE);
+		}
+
+		*memory = 0;
+		memcpy(memory + 1, object, sizeof(T));
+
+		*(reinterpret_cast<CounterType *>(object) - 1) = FORWARDED;
+		*reinterpret_cast<T **>(object) = reinterpret_cast<T *>(memory + 1);
+	}
+
+	return *reinterpret_cast<T **>(object);
+}
+#endif /* GENERATIONAL */
+
+// Immortal nodes are not in the heap, so they are never marked (nor freed)
+static LispNode *mark_node(LispNode *node) {
+	if(node == nullptr || LispNode::is_immortal(node)) {
+		return node;
+	}
+
+#ifdef GENERATIONAL
+	if(SimpleAllocator::is_young(node)) {
+		bool copied;
+		node = forward(node, copied);
+
+		if(copied) {
+			if(!young_only) {
+				SimpleAllocator::set_mark(node);
+			}
+
+			push_pending(node);
+		}
+
+		return node;
+	}
+
+	if(young_only) {
+		return node;
+	}
+#endif /* GENERATIONAL */
+
+	if(!SimpleAllocator::get_mark(node)) {
+		SimpleAllocator::set_mark(node);
+		push_pending(node);
+	}
+
+	return node;
+}
+
+static void mark_slot(LispNodeRC &slot) {
+	LispNode *node = mark_node(slot.get_pointer());
+
+	if(node != slot.get_pointer()) {
+		slot = node;
+	}
+}
+
+// Boxes are only reachable through their lists, so they are marked along the way
+static void mark_boxes(BoxRC *slot) {
+	for(Box *box = slot->get_pointer(); box != nullptr; box = slot->get_pointer()) {
+#ifdef GENERATIONAL
+		if(SimpleAllocator::is_young(box)) {
+			bool copied;
+			*slot = box = forward(box, copied);
+
+			// Otherwise the rest of the list was copied along with it
+			if(!copied) {
+				return;
+			}
+
+			if(!young_only) {
+				SimpleAllocator::set_mark(box);
+			}
+		}
+		else if(young_only) {
+			return;
+		}
+		else
+#endif /* GENERATIONAL */
+		{
+			if(SimpleAllocator::get_mark(box)) {
+				return;
+			}
+
+			SimpleAllocator::set_mark(box);
+		}
+
+		mark_slot(box->item);
+		slot = &box->next;
+	}
+}
+
+static void mark_contents(LispNode *node) {
+	switch(node->type) {
+		case LispType::List:
+			mark_boxes(&node->head);
+			break;
+		case LispType::AtomPure:
+			mark_slot(node->symbol->value);
+			break;
+		case LispType::AtomLocal:
+			mark_slot(node->local->symbol);
+			break;
+		case LispType::AtomCode:
+			mark_slot(node->code->parameters);
+
+			for(unsigned int i = 0; i < node->code->number_constants; i++) {
+				mark_slot(node->code->constants[i]);
+			}
+
+			break;
+#ifdef VECTORS
+		case LispType::AtomVector:
+			for(unsigned int i = 0; i < node->vector->length; i++) {
+				mark_slot(node->vector->items[i]);
+			}
+
+			break;
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case LispType::AtomHashMap:
+			for(unsigned int i = 0; i < node->hash_map->capacity; i++) {
+				mark_slot(node->hash_map->keys[i]);
+				mark_slot(node->hash_map->values[i]);
+			}
+
+			break;
+#endif /* HASH_TABLES */
+		default:
+			break;
+	}
+}
+
+static void scan(LispNode *node) {
+#ifdef GENERATIONAL
+	// Every node scanned is either just copied out of the nursery, or live in a full collection
+	if(is_container(node) && !push(old_containers, old_containers_capacity, old_containers_count, node)) {
+		old_containers_lost = true;
+	}
+#endif /* GENERATIONAL */
+
+	mark_contents(node);
+}
+
+static void mark_pending() {
+	while(pending_count > 0) {
+		scan(pending[--pending_count]);
+	}
+}
+
+void GarbageCollector::setup() {
+	out_of_memory = false;
+
+#ifdef GENERATIONAL
+	young_only = !(SimpleAllocator::number_allocated >= threshold || SimpleAllocator::remembered_lost || old_containers_lost);
+
+	if(young_only) {
+		// Old objects are taken as live, so their slots into the nursery are roots
+		for(unsigned int i = 0; i < SimpleAllocator::number_remembered[IndexLispNode]; i++) {
+			mark_slot(*static_cast<LispNodeRC *>(SimpleAllocator::remembered[IndexLispNode][i]));
+		}
+
+		for(unsigned int i = 0; i < SimpleAllocator::number_remembered[IndexBox]; i++) {
+			mark_boxes(static_cast<BoxRC *>(SimpleAllocator::remembered[IndexBox][i]));
+		}
+
+		// Containers copied from here on are appended, and already scanned
+		unsigned int number_containers = old_containers_count;
+
+		for(unsigned int i = 0; i < number_containers; i++) {
+			mark_contents(old_containers[i]);
+		}
+
+		mark_pending();
+
+		return;
+	}
+
+	// Rebuilt while marking, with only the live ones
+	old_containers_count = 0;
+	old_containers_lost = false;
+#endif /* GENERATIONAL */
+
+	SimpleAllocator::setup();
+}
+
+void GarbageCollector::mark(LispNodeRC &node) {
+	mark_slot(node);
+	mark_pending();
+}
+
+void GarbageCollector::commit() {
+#ifdef GENERATIONAL
+	// Nodes left in the nursery are dead
+	for(unsigned int i = 0; i < young_owners_count; i++) {
+		if(!is_forwarded(young_owners[i])) {
+			young_owners[i]->~LispNode();
+		}
+	}
+
+	young_owners_count = 0;
+
+	SimpleAllocator::reset_nursery();
+#endif /* GENERATIONAL */
+
+	Deallocate(pending);
+
+	pending = nullptr;
+	pending_capacity = 0;
+	pending_count = 0;
+
+#ifdef GENERATIONAL
+	if(young_only) {
+		return;
+	}
+#endif /* GENERATIONAL */
+
+	if(!out_of_memory) {
+		SimpleAllocator::commit();
+	}
+
+	threshold = (2 * SimpleAllocator::number_allocated > MINIMUM_THRESHOLD ? 2 * SimpleAllocator::number_allocated : MINIMUM_THRESHOLD);
+}
+
+#ifdef GENERATIONAL
+void GarbageCollector::track(LispNode *node) {
+	// If a young owner is not recorded, the memory it holds is leaked when it dies
+	if(SimpleAllocator::is_young(node)) {
+		push(young_owners, young_owners_capacity, young_owners_count, node);
+	}
+	else if(is_container(node) && !push(old_containers, old_containers_capacity, old_containers_count, node)) {
+		old_containers_lost = true;
+	}
+}
+
+Box *GarbageCollector::relocate(Box *box) {
+	if(box != nullptr && SimpleAllocator::is_young(box) && is_forwarded(box)) {
+		return *reinterpret_cast<Box **>(box);
+	}
+
+	return box;
+}
+#endif /* GENERATIONAL */
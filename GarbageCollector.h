@@ -0,0 +1,73 @@
+#ifndef GARBAGE_COLLECTOR_H
+#define GARBAGE_COLLECTOR_H
+
+#include "LispNode.h"
+#include "SimpleAllocator.h"
+
+#ifdef REFERENCE_COUNTING
+#error "MARK_AND_SWEEP is for builds without REFERENCE_COUNTING"
+#endif /* REFERENCE_COUNTING */
+
+// Tracing (mark-and-sweep) collection, for builds without reference counting
+//
+// The caller marks every root between setup() and commit(), and commit() frees the nodes and boxes
+// that were not reached. Marking keeps its pending nodes in a heap array instead of recursing, so
+// deep structures do not exhaust the hardware stack. Cycles (such as closures stored in the
+// environments they capture) are freed like any other unreachable structure.
+//
+// With GENERATIONAL, new objects are taken from the nursery, and most collections only look at it:
+// the survivors are copied into the old generation (so marking may change the slot it is given),
+// starting from the roots, the slots of old objects that were made to point into the nursery
+// (recorded by RCPointer), and the slots outside nodes and boxes of old containers (symbols,
+// locals, code, vectors, hash maps). The old generation is traced and swept as above once it holds
+// twice what survived the last full collection.
+
+struct GarbageCollector {
+	// Objects allocated that make the next collection due (twice what survived the last one)
+	static unsigned long threshold;
+
+	static bool is_due() {
+#ifdef GENERATIONAL
+		return (SimpleAllocator::young_collection_due || SimpleAllocator::number_allocated >= threshold);
+#else
+		return (SimpleAllocator::number_allocated >= threshold);
+#endif /* GENERATIONAL */
+	}
+
+	static void setup();
+
+	// Marks the node and everything reachable from it
+	static void mark(LispNodeRC &node);
+
+	// Frees everything not marked (nothing, if marking ran out of memory)
+	static void commit();
+
+#ifdef GENERATIONAL
+	// Called for every new node: the ones holding memory outside the heap are tracked, so that
+	// nursery nodes are destroyed if they die young, and old containers are scanned as roots
+	static void register_node(LispNode *node) {
+		switch(node->type) {
+			case LispType::AtomPure:
+			case LispType::AtomString:
+			case LispType::AtomNumericBig:
+			case LispType::AtomData:
+			case LispType::AtomLocal:
+			case LispType::AtomCode:
+			case LispType::AtomVector:
+			case LispType::AtomHashMap:
+				track(node);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Where a box is after marking (for pointers to boxes kept outside the heap)
+	static Box *relocate(Box *box);
+
+private:
+	static void track(LispNode *node);
+#endif /* GENERATIONAL */
+};
+
+#endif /* GARBAGE_COLLECTOR_H */
@@ -0,0 +1,142 @@
+#include "HashMap.h"
+
+#include "SymbolTable.h"
+
+#include "extra.h"
+
+#ifdef TARGET_6502
+static constexpr unsigned int INITIAL_CAPACITY = 8;
+#else
+static constexpr unsigned int INITIAL_CAPACITY = 16;
+#endif /* TARGET_6502 */
+
+static size_t hash_key(const LispNodeRC &key) {
+	if(key->is_numeric_integral() || key->is_character()) {
+		return static_cast<size_t>(key->number_i) * 2654435761u;
+	}
+
+#ifdef BIGNUMS
+	// Bignums never fit an Integral, so they are hashed by their limbs (equal values have equal limbs)
+	if(key->is_numeric_big()) {
+		return hash_bytes(key->bignum->limbs, key->bignum->length * sizeof(Limb)) + key->bignum->negative;
+	}
+#endif /* BIGNUMS */
+
+	return hash_string(key->is_pure() ? key->symbol->name : key->get_string());
+}
+
+HashMap::HashMap(): capacity{INITIAL_CAPACITY}, count{0} {
+	keys = new LispNodeRC[capacity];
+	values = new LispNodeRC[capacity];
+}
+
+HashMap::~HashMap() {
+	delete[] keys;
+	delete[] values;
+}
+
+bool HashMap::is_valid_key(const LispNodeRC &key) {
+	return (key->is_pure() || key->is_string() || key->is_numeric_integral() || key->is_numeric_big() || key->is_character());
+}
+
+unsigned int HashMap::find_slot(const LispNodeRC &key) const {
+	unsigned int position = hash_key(key) & (capacity - 1);
+
+	while(keys[position] != nullptr && !(keys[position] == key)) {
+		position = (position + 1) & (capacity - 1);
+	}
+
+	return position;
+}
+
+void HashMap::grow() {
+	LispNodeRC *old_keys = keys;
+	LispNodeRC *old_values = values;
+
+	unsigned int old_capacity = capacity;
+
+	capacity *= 2;
+
+	keys = new LispNodeRC[capacity];
+	values = new LispNodeRC[capacity];
+
+	for(unsigned int i = 0; i < old_capacity; i++) {
+		if(old_keys[i] != nullptr) {
+			unsigned int position = find_slot(old_keys[i]);
+
+			keys[position] = old_keys[i];
+			values[position] = old_values[i];
+		}
+	}
+
+	delete[] old_keys;
+	delete[] old_values;
+}
+
+LispNodeRC HashMap::copy_key(const LispNodeRC &key) {
+	if(!key->is_string()) {
+		return key;
+	}
+
+	// Strings may contain nul characters, so the length is not taken from the terminator
+	size_t length = key->get_string_length();
+
+	LispNodeRC result = LispNode::make_string(length);
+
+	memcpy(result->get_string(), key->get_string(), length);
+
+	return result;
+}
+
+LispNodeRC HashMap::get(const LispNodeRC &key) const {
+	return values[find_slot(key)];
+}
+
+void HashMap::set(const LispNodeRC &key, const LispNodeRC &value) {
+	unsigned int position = find_slot(key);
+
+	if(keys[position] != nullptr) {
+		values[position] = value;
+
+		return;
+	}
+
+	keys[position] = copy_key(key);
+
+	values[position] = value;
+	count++;
+
+	// Keep the load factor under 3/4 so probe sequences stay short
+	if(4 * count >= 3 * capacity) {
+		grow();
+	}
+}
+
+bool HashMap::remove(const LispNodeRC &key) {
+	unsigned int hole = find_slot(key);
+
+	if(keys[hole] == nullptr) {
+		return false;
+	}
+
+	keys[hole] = nullptr;
+	values[hole] = nullptr;
+	count--;
+
+	// Moves back the entries after the hole that probed past it, so no tombstones are needed
+	for(unsigned int position = (hole + 1) & (capacity - 1); keys[position] != nullptr; position = (position + 1) & (capacity - 1)) {
+		unsigned int home = hash_key(keys[position]) & (capacity - 1);
+
+		if(((position - home) & (capacity - 1)) >= ((position - hole) & (capacity - 1))) {
+			keys[hole] = keys[position];
+			values[hole] = values[position];
+
+			keys[position] = nullptr;
+			values[position] = nullptr;
+
+			hole = position;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+
+#include "LispNode.h"
+
+// Hash table keyed by symbols, strings, integers (including bignums) or characters, for constant-time
+// insertion, lookup and deletion (keys are compared as in eq?)
+
+struct HashMap {
+	// Open addressing as in the symbol table, but removals shift entries back instead of leaving tombstones
+	LispNodeRC *keys;
+	LispNodeRC *values;
+
+	unsigned int capacity;
+	unsigned int count;
+
+	HashMap();
+	~HashMap();
+
+	static bool is_valid_key(const LispNodeRC &key);
+
+	// Strings can be changed in place, so string keys are stored and handed out as private copies
+	static LispNodeRC copy_key(const LispNodeRC &key);
+
+	// Returns nullptr if the key is not present
+	LispNodeRC get(const LispNodeRC &key) const;
+
+	void set(const LispNodeRC &key, const LispNodeRC &value);
+	bool remove(const LispNodeRC &key);
+
+private:
+	unsigned int find_slot(const LispNodeRC &key) const;
+	void grow();
+};
+
+#endif /* HASH_MAP_H */
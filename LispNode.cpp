@@ -1,18 +1,104 @@
 #include "LispNode.h"
 
+#include <new>
+
+#include "SymbolTable.h"
+#include "Bytecode.h"
+
+#ifdef HASH_TABLES
+#include "HashMap.h"
+#endif /* HASH_TABLES */
+
+#ifdef GENERATIONAL
+#include "GarbageCollector.h"
+#endif /* GENERATIONAL */
+
 #include "operators.h"
 #include "extra.h"
 
+// Immortal nodes
+//
+// Operators, small integers, characters, the booleans and the empty list are built once, in a single static
+// block, when the interpreter starts. Producing one of these values returns its node instead of
+// allocating a new one, and RCPointer does not count references to them (they are never freed).
+// An address range check tells them apart, so nothing else about LispNode changes; nodes in the
+// block must never be changed in place.
+
+alignas(LispNode) static unsigned char immortal_storage[NUMBER_IMMORTAL_NODES * sizeof(LispNode)];
+
+LispNode *LispNode::immortal_nodes = reinterpret_cast<LispNode *>(immortal_storage);
+
+static constexpr unsigned int FIRST_IMMORTAL_OPERATOR = NUMBER_IMMORTAL_CONSTANTS;
+static constexpr unsigned int FIRST_IMMORTAL_CHARACTER = FIRST_IMMORTAL_OPERATOR + NUMBER_BASIC_OPERATORS;
+static constexpr unsigned int FIRST_IMMORTAL_INTEGER = FIRST_IMMORTAL_CHARACTER + NUMBER_SMALL_CHARACTERS;
+
+static unsigned int number_immortal_constants = 0;
+
 LispNode::LispNode(LispType type): type{type}, head{nullptr} {
+#ifdef GENERATIONAL
+	GarbageCollector::register_node(this);
+#endif /* GENERATIONAL */
+}
+
+void LispNode::init() {
+	for(unsigned int i = 0; i < NUMBER_BASIC_OPERATORS; i++) {
+		LispNode *operation = ::new(&immortal_nodes[FIRST_IMMORTAL_OPERATOR + i]) LispNode(LispType::AtomOperator);
+		operation->number_i = i;
+	}
+
+	for(unsigned int i = 0; i < NUMBER_SMALL_CHARACTERS; i++) {
+		LispNode *character = ::new(&immortal_nodes[FIRST_IMMORTAL_CHARACTER + i]) LispNode(LispType::AtomCharacter);
+		character->number_i = i;
+	}
+
+	for(Integral i = SMALL_INTEGER_MINIMUM; i <= SMALL_INTEGER_MAXIMUM; i++) {
+		LispNode *integer = ::new(&immortal_nodes[FIRST_IMMORTAL_INTEGER + (i - SMALL_INTEGER_MINIMUM)]) LispNode(LispType::AtomNumericIntegral);
+		integer->number_i = i;
+	}
 }
 
 LispNode::~LispNode() {
-	if(type == LispType::AtomPure || type == LispType::AtomBoolean || type == LispType::AtomString || type == LispType::AtomData) {
+	if(type == LispType::AtomBoolean || type == LispType::AtomData) {
 		if(data != nullptr) {
 			free(data);
 		}
 	}
 
+	// The length is stored right before the characters
+	if(type == LispType::AtomString) {
+		free(reinterpret_cast<size_t *>(data) - 1);
+	}
+
+	if(type == LispType::AtomPure) {
+		delete symbol;
+	}
+
+	if(type == LispType::AtomLocal) {
+		delete local;
+	}
+
+	if(type == LispType::AtomCode) {
+		delete code;
+	}
+
+#ifdef VECTORS
+	if(type == LispType::AtomVector) {
+		delete vector;
+	}
+#endif /* VECTORS */
+
+#ifdef HASH_TABLES
+	if(type == LispType::AtomHashMap) {
+		delete hash_map;
+	}
+#endif /* HASH_TABLES */
+
+#ifdef BIGNUMS
+	if(type == LispType::AtomNumericBig) {
+		delete bignum;
+	}
+#endif /* BIGNUMS */
+
 	// Forces the deletion of all elements in the list if REFERENCE_COUNTING is defined
 	if(type == LispType::List) {
 		head = nullptr;
@@ -35,7 +121,33 @@ LispNode *LispNode::make_data(LispType type, void *data) {
 	return result;
 }
 
+LispNode *LispNode::make_symbol(const char *name) {
+	return SymbolTable::intern(name);
+}
+
+LispNode *LispNode::make_local(const LispNodeRC &symbol, unsigned int offset) {
+	LispNode *result = new LispNode(LispType::AtomLocal);
+
+	result->local = new Local(symbol, offset);
+
+	return result;
+}
+
+// Takes the next of the slots reserved for global constants
+LispNode *LispNode::make_immortal(LispType type) {
+	return ::new(&immortal_nodes[number_immortal_constants++]) LispNode(type);
+}
+
+// Every occurrence of an operator shares the same node
+LispNode *LispNode::make_operator(int operation_index) {
+	return &immortal_nodes[FIRST_IMMORTAL_OPERATOR + operation_index];
+}
+
 LispNode *LispNode::make_integer(Integral number_i) {
+	if(number_i >= SMALL_INTEGER_MINIMUM && number_i <= SMALL_INTEGER_MAXIMUM) {
+		return &immortal_nodes[FIRST_IMMORTAL_INTEGER + (number_i - SMALL_INTEGER_MINIMUM)];
+	}
+
 	LispNode *result = new LispNode(LispType::AtomNumericIntegral);
 
 	result->number_i = number_i;
@@ -43,7 +155,19 @@ LispNode *LispNode::make_integer(Integral number_i) {
 	return result;
 }
 
-LispNode *LispNode::make_real(Integral number_r) {
+LispNode *LispNode::make_character(Integral number_i) {
+	if(number_i >= 0 && number_i < NUMBER_SMALL_CHARACTERS) {
+		return &immortal_nodes[FIRST_IMMORTAL_CHARACTER + number_i];
+	}
+
+	LispNode *result = new LispNode(LispType::AtomCharacter);
+
+	result->number_i = number_i;
+
+	return result;
+}
+
+LispNode *LispNode::make_real(Real number_r) {
 	LispNode *result = new LispNode(LispType::AtomNumericReal);
 
 	result->number_r = number_r;
@@ -51,6 +175,25 @@ LispNode *LispNode::make_real(Integral number_r) {
 	return result;
 }
 
+#ifdef BIGNUMS
+// Takes the bignum; values that fit an Integral are made plain integers instead
+LispNode *LispNode::make_bignum(Bignum *bignum) {
+	if(bignum->fits_integral()) {
+		Integral number_i = bignum->get_integral();
+
+		delete bignum;
+
+		return make_integer(number_i);
+	}
+
+	LispNode *result = new LispNode(LispType::AtomNumericBig);
+
+	result->bignum = bignum;
+
+	return result;
+}
+#endif /* BIGNUMS */
+
 LispNode *LispNode::make_list(Box *head) {
 	LispNode *result = new LispNode(LispType::List);
 
@@ -59,6 +202,75 @@ LispNode *LispNode::make_list(Box *head) {
 	return result;
 }
 
+LispNode *LispNode::make_string(size_t length) {
+	LispNode *result;
+
+	if(length < SHORT_STRING_SIZE) {
+		result = new LispNode(LispType::AtomShortString);
+
+		// The last byte holds the unused capacity, so it is also the terminator of a full buffer
+		result->short_string[length] = '\0';
+		result->short_string[SHORT_STRING_SIZE - 1] = static_cast<char>(SHORT_STRING_SIZE - 1 - length);
+	}
+	else {
+		result = new LispNode(LispType::AtomString);
+
+		size_t *block = static_cast<size_t *>(malloc(sizeof(size_t) + length + 1));
+		block[0] = length;
+
+		result->data = reinterpret_cast<char *>(block + 1);
+		result->data[length] = '\0';
+	}
+
+	return result;
+}
+
+LispNode *LispNode::make_string(const char *characters) {
+	size_t length = strlen(characters);
+
+	LispNode *result = make_string(length);
+
+	memcpy(result->get_string(), characters, length);
+
+	return result;
+}
+
+size_t LispNode::get_string_length() const {
+	if(type == LispType::AtomShortString) {
+		return SHORT_STRING_SIZE - 1 - static_cast<unsigned char>(short_string[SHORT_STRING_SIZE - 1]);
+	}
+
+	return reinterpret_cast<const size_t *>(data)[-1];
+}
+
+#ifdef VECTORS
+LispNode *LispNode::make_vector(unsigned int length, const LispNodeRC &fill) {
+	Vector *vector = new Vector(length, fill);
+
+	if(vector->items == nullptr) {
+		delete vector;
+
+		return nullptr;
+	}
+
+	LispNode *result = new LispNode(LispType::AtomVector);
+
+	result->vector = vector;
+
+	return result;
+}
+#endif /* VECTORS */
+
+#ifdef HASH_TABLES
+LispNode *LispNode::make_hash_map() {
+	LispNode *result = new LispNode(LispType::AtomHashMap);
+
+	result->hash_map = new HashMap();
+
+	return result;
+}
+#endif /* HASH_TABLES */
+
 bool LispNode::operator==(const LispNode &other) const {
 	if(type != other.type) {
 		return false;
@@ -67,14 +279,26 @@ bool LispNode::operator==(const LispNode &other) const {
 	switch(type) {
 		case AtomPure:
 		case AtomBoolean:
+			// Symbols are interned and booleans are unique, so identity is equality
+			return (this == &other);
 		case AtomString:
-			return (strcmp(data, other.data) == 0);
+		case AtomShortString:
+			// Strings are short exactly when their length is, so equal strings have the same type
+			return (get_string_length() == other.get_string_length() && memcmp(get_string(), other.get_string(), get_string_length()) == 0);
 		case AtomCharacter:
 		case AtomOperator:
 		case AtomNumericIntegral:
 			return (number_i == other.number_i);
 		case AtomNumericReal:
 			return (number_r == other.number_r);
+#ifdef BIGNUMS
+		case AtomNumericBig:
+			return (Bignum::compare(*bignum, *other.bignum) == 0);
+#endif /* BIGNUMS */
+		case AtomLocal:
+		case AtomCode:
+		case AtomVector:
+		case AtomHashMap:
 		case List:
 			return (this == &other);
 		default:
@@ -99,7 +323,7 @@ bool LispNode::is_boolean() const {
 }
 
 bool LispNode::is_string() const {
-	return (type == LispType::AtomString);
+	return (type == LispType::AtomString || type == LispType::AtomShortString);
 }
 
 bool LispNode::is_character() const {
@@ -111,7 +335,7 @@ bool LispNode::is_operator() const {
 }
 
 bool LispNode::is_numeric() const {
-	return (type == LispType::AtomNumericIntegral || type == LispType::AtomNumericReal);
+	return (type == LispType::AtomNumericIntegral || type == LispType::AtomNumericReal || type == LispType::AtomNumericBig);
 }
 
 bool LispNode::is_numeric_integral() const {
@@ -122,131 +346,286 @@ bool LispNode::is_numeric_real() const {
 	return (type == LispType::AtomNumericReal);
 }
 
+bool LispNode::is_numeric_big() const {
+	return (type == LispType::AtomNumericBig);
+}
+
 bool LispNode::is_data() const {
 	return (type == LispType::AtomData);
 }
 
+bool LispNode::is_local() const {
+	return (type == LispType::AtomLocal);
+}
+
+bool LispNode::is_code() const {
+	return (type == LispType::AtomCode);
+}
+
+bool LispNode::is_vector() const {
+	return (type == LispType::AtomVector);
+}
+
+bool LispNode::is_hash_map() const {
+	return (type == LispType::AtomHashMap);
+}
+
 bool LispNode::is_operation(int operator_index) const {
 	return (is_list() && head.get_pointer() != nullptr && head->item->type == LispType::AtomOperator && head->item->number_i == operator_index);
 }
 
-void LispNode::op_arithmetic(int operation, LispNodeRC &first, LispNodeRC &second) {
-	is_numeric_integral() ? op_arithmetic_integer(operation, first, second) : op_arithmetic_real(operation, first, second);
+// Integer overflow checks: GCC and Clang have builtins for them, other compilers check the operands first
+
+#ifdef __GNUC__
+#define add_overflows(first, second, result) __builtin_add_overflow(first, second, result)
+#define subtract_overflows(first, second, result) __builtin_sub_overflow(first, second, result)
+#define multiply_overflows(first, second, result) __builtin_mul_overflow(first, second, result)
+#else
+static bool add_overflows(Integral first, Integral second, Integral *result) {
+	if((second > 0 && first > INTEGRAL_MAXIMUM - second) || (second < 0 && first < INTEGRAL_MINIMUM - second)) {
+		return true;
+	}
+
+	*result = first + second;
+
+	return false;
+}
+
+static bool subtract_overflows(Integral first, Integral second, Integral *result) {
+	if((second < 0 && first > INTEGRAL_MAXIMUM + second) || (second > 0 && first < INTEGRAL_MINIMUM + second)) {
+		return true;
+	}
+
+	*result = first - second;
+
+	return false;
 }
 
-bool LispNode::op_comparison(int operation, LispNodeRC &other) {
-	return (is_numeric_integral() ? op_comparison_integer(operation, other) : op_comparison_real(operation, other));
+static bool multiply_overflows(Integral first, Integral second, Integral *result) {
+	if(first != 0 && second != 0) {
+		bool overflow;
+
+		if(first > 0) {
+			overflow = (second > 0 ? first > INTEGRAL_MAXIMUM / second : second < INTEGRAL_MINIMUM / first);
+		}
+		else {
+			overflow = (second > 0 ? first < INTEGRAL_MINIMUM / second : first < INTEGRAL_MAXIMUM / second);
+		}
+
+		if(overflow) {
+			return true;
+		}
+	}
+
+	*result = first * second;
+
+	return false;
 }
+#endif /* __GNUC__ */
+
+// Arithmetic and comparisons work on values, so the operand nodes (which may be shared) are never changed
+
+// Returns false (leaving the result as it was) if the result does not fit an Integral
+bool LispNode::op_arithmetic_integer(int operation, Integral first, Integral second, Integral &result) {
+	Integral value = 0;
+	bool overflow = false;
 
-void LispNode::op_arithmetic_integer(int operation, LispNodeRC &first, LispNodeRC &second) {
 	switch(operation) {
 		case OP_PLUS:
-			number_i = (first->number_i + second->number_i);
+			overflow = add_overflows(first, second, &value);
 			break;
 		case OP_MINUS:
-			number_i = (first->number_i - second->number_i);
+			overflow = subtract_overflows(first, second, &value);
 			break;
 		case OP_TIMES:
-			number_i = (first->number_i * second->number_i);
+			overflow = multiply_overflows(first, second, &value);
 			break;
 		case OP_DIVIDE:
-			number_i = (first->number_i / second->number_i);
+		case OP_QUOTIENT:
+			// The only quotient out of range
+			overflow = (first == INTEGRAL_MINIMUM && second == -1);
+
+			if(!overflow) {
+				value = (first / second);
+			}
+
+			break;
+		case OP_REMAINDER:
+		case OP_MODULO:
+			// Dividing the most negative value by -1 would overflow, even though the remainder is zero
+			value = (second == -1 ? 0 : first % second);
+
+			// The remainder has the sign of the dividend, and the modulo the sign of the divisor
+			if(operation == OP_MODULO && value != 0 && (value < 0) != (second < 0)) {
+				value += second;
+			}
+
+			break;
+		case OP_BITWISE_AND:
+			value = (first & second);
+			break;
+		case OP_BITWISE_OR:
+			value = (first | second);
+			break;
+		case OP_BITWISE_XOR:
+			value = (first ^ second);
+			break;
+		case OP_ARITHMETIC_SHIFT: {
+			constexpr Integral INTEGRAL_BITS = sizeof(Integral) * 8;
+
+			if(second >= 0) {
+				// Overflows unless shifting back gives the same value
+				overflow = (first != 0 && (second >= INTEGRAL_BITS - 1 || ((first << second) >> second) != first));
+
+				if(!overflow) {
+					value = (first << second);
+				}
+			}
+			else {
+				// Negative shifts go right, rounding towards negative infinity
+				value = (second <= -INTEGRAL_BITS ? (first < 0 ? -1 : 0) : (first >> -second));
+			}
+
 			break;
+		}
 	}
+
+	if(overflow) {
+		return false;
+	}
+
+	result = value;
+
+	return true;
 }
 
-void LispNode::op_arithmetic_real(int operation, LispNodeRC &first, LispNodeRC &second) {
+Real LispNode::op_arithmetic_real(int operation, Real first, Real second) {
 	switch(operation) {
 		case OP_PLUS:
-			number_r = (first->number_r + second->number_r);
-			break;
+			return (first + second);
 		case OP_MINUS:
-			number_r = (first->number_r - second->number_r);
-			break;
+			return (first - second);
 		case OP_TIMES:
-			number_r = (first->number_r * second->number_r);
-			break;
+			return (first * second);
 		case OP_DIVIDE:
-			number_r = (first->number_r / second->number_r);
-			break;
+			return (first / second);
 	}
+
+	return first;
 }
 
-bool LispNode::op_comparison_integer(int operation, LispNodeRC &other) {
-	bool comparison_result = false;
+#ifdef BIGNUMS
+Bignum *LispNode::op_arithmetic_big(int operation, const Bignum &first, const Bignum &second) {
+	switch(operation) {
+		case OP_PLUS:
+			return Bignum::add(first, second);
+		case OP_MINUS:
+			return Bignum::subtract(first, second);
+		case OP_TIMES:
+			return Bignum::multiply(first, second);
+		case OP_DIVIDE:
+		case OP_QUOTIENT:
+			return Bignum::divide(first, second);
+		case OP_REMAINDER:
+		case OP_MODULO: {
+			Bignum *remainder;
+
+			delete Bignum::divide(first, second, &remainder);
+
+			// The remainder has the sign of the dividend, and the modulo the sign of the divisor
+			if(operation == OP_MODULO && !remainder->is_zero() && remainder->negative != second.negative) {
+				Bignum *modulo = Bignum::add(*remainder, second);
+
+				delete remainder;
+
+				return modulo;
+			}
+
+			return remainder;
+		}
+		case OP_ARITHMETIC_SHIFT:
+			if(!second.fits_integral()) {
+				return nullptr;
+			}
+
+			return Bignum::shift(first, second.get_integral());
+	}
+
+	// Bitwise operations only take plain integers
+	return nullptr;
+}
+#endif /* BIGNUMS */
 
+bool LispNode::op_comparison_integer(int operation, Integral first, Integral second) {
 	switch(operation) {
 		case OP_LESS:
-			comparison_result = (number_i < other->number_i);
-			break;
+			return (first < second);
 		case OP_BIGGER:
-			comparison_result = (number_i > other->number_i);
-			break;
+			return (first > second);
 		case OP_EQUAL:
-			comparison_result = (number_i == other->number_i);
-			break;
+			return (first == second);
 		case OP_LESS_EQUAL:
-			comparison_result = (number_i <= other->number_i);
-			break;
+			return (first <= second);
 		case OP_BIGGER_EQUAL:
-			comparison_result = (number_i >= other->number_i);
-			break;
+			return (first >= second);
 	}
 
-	return comparison_result;
+	return false;
 }
 
-bool LispNode::op_comparison_real(int operation, LispNodeRC &other) {
-	bool comparison_result = false;
-
+bool LispNode::op_comparison_real(int operation, Real first, Real second) {
 	switch(operation) {
 		case OP_LESS:
-			comparison_result = (number_r < other->number_r);
-			break;
+			return (first < second);
 		case OP_BIGGER:
-			comparison_result = (number_r > other->number_r);
-			break;
+			return (first > second);
 		case OP_EQUAL:
-			comparison_result = (number_r == other->number_r);
-			break;
+			return (first == second);
 		case OP_LESS_EQUAL:
-			comparison_result = (number_r <= other->number_r);
-			break;
+			return (first <= second);
 		case OP_BIGGER_EQUAL:
-			comparison_result = (number_r >= other->number_r);
-			break;
+			return (first >= second);
 	}
 
-	return comparison_result;
+	return false;
 }
 
-void LispNode::promoteReal() {
-	Integral integral = number_i;
+// Value of a numeric node as a real, for operations mixing integers and reals
+Real LispNode::get_real() const {
+	if(type == LispType::AtomNumericReal) {
+		return number_r;
+	}
 
-	type = LispType::AtomNumericReal;
-	number_r = integral;
-}
+#ifdef BIGNUMS
+	if(type == LispType::AtomNumericBig) {
+		return bignum->get_real();
+	}
+#endif /* BIGNUMS */
 
-void LispNode::demoteReal() {
-	Real real = number_r;
+	Real real = number_i;
 
-	type = LispType::AtomNumericIntegral;
-#ifdef TARGET_6502
-	number_i = real.as_i();
-#else
-	number_i = real;
-#endif /* TARGET_6502 */
+	return real;
+}
+
+#ifdef BIGNUMS
+// Value of an integer node (big or not) as a bignum, for operations mixing them
+Bignum LispNode::get_bignum() const {
+	return (type == LispType::AtomNumericBig ? Bignum(*bignum) : Bignum(number_i));
 }
+#endif /* BIGNUMS */
 
 void LispNode::print() const {
 	switch(type) {
 		case AtomPure:
+			fputs(symbol->name, stdout);
+			break;
 		case AtomBoolean:
 			fputs(data, stdout);
 			break;
 		case AtomString:
+		case AtomShortString:
 			fputs("\"", stdout);
-			fputs(data, stdout);
+			fputs(get_string(), stdout);
 			fputs("\"", stdout);
 			break;
 		case AtomCharacter:
@@ -262,11 +641,49 @@ void LispNode::print() const {
 		case AtomNumericReal:
 			print_real(number_r);
 			break;
+#ifdef BIGNUMS
+		case AtomNumericBig: {
+			char *digits = bignum->get_string();
+
+			fputs(digits, stdout);
+			Deallocate(digits);
+
+			break;
+		}
+#endif /* BIGNUMS */
 		case AtomData:
 			fputs("[data: ", stdout);
 			print_integral((size_t) data);
 			fputs("]", stdout);
 			break;
+		case AtomLocal:
+			local->symbol->print();
+			break;
+		case AtomCode:
+			fputs("#", stdout);
+			fputs("code", stdout);
+			break;
+#ifdef VECTORS
+		case AtomVector:
+			fputs("#(", stdout);
+
+			for(unsigned int i = 0; i < vector->length; i++) {
+				vector->items[i]->print();
+
+				if(i + 1 < vector->length) {
+					fputs(" ", stdout);
+				}
+			}
+
+			fputs(")", stdout);
+			break;
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case AtomHashMap:
+			fputs("#", stdout);
+			fputs("hash-table", stdout);
+			break;
+#endif /* HASH_TABLES */
 		case List:
 			if(is_operation(OP_CLOSURE)) {
 				fputs("#", stdout);
@@ -297,9 +714,34 @@ void LispNode::print() const {
 			}
 
 			fputs(")", stdout);
+			break;
+		default:
+			// Types left out of the build are never made
+			break;
 	}
 }
 
+Local::Local(const LispNodeRC &symbol, unsigned int offset): symbol{symbol}, offset{offset} {
+}
+
+#ifdef VECTORS
+Vector::Vector(unsigned int length, const LispNodeRC &fill): length{length} {
+	items = new (std::nothrow) LispNodeRC[length];
+
+	if(items == nullptr) {
+		return;
+	}
+
+	for(unsigned int i = 0; i < length; i++) {
+		items[i] = fill;
+	}
+}
+
+Vector::~Vector() {
+	delete[] items;
+}
+#endif /* VECTORS */
+
 Box::Box(const LispNodeRC &item): item{item} {
 }
 
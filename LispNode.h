@@ -4,12 +4,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "types.h"
+#include "operators.h"
+
+#ifdef BIGNUMS
+#include "Bignum.h"
+#endif /* BIGNUMS */
 
 // Forward declaration
 struct LispNode;
 struct Box;
+struct Symbol;
+struct Local;
+struct Vector;
+struct HashMap;
+struct Bignum;
+struct Bytecode;
 
 #include "Allocator.hpp"
 #include "RCPointer.hpp"
@@ -21,40 +33,107 @@ enum LispType : unsigned char {
 	AtomPure,
 	AtomBoolean,
 	AtomString,
+	AtomShortString,
 	AtomCharacter,
 	AtomOperator,
 	AtomNumericIntegral,
 	AtomNumericReal,
+	AtomNumericBig,
 	AtomData,
+	AtomLocal,
+	AtomCode,
+	AtomVector,
+	AtomHashMap,
 	List
 };
 
+// Immortal nodes (see LispNode.cpp)
+#ifdef TARGET_6502
+constexpr Integral SMALL_INTEGER_MINIMUM = -8;
+constexpr Integral SMALL_INTEGER_MAXIMUM = 63;
+constexpr unsigned int NUMBER_SMALL_CHARACTERS = 128;
+#else
+constexpr Integral SMALL_INTEGER_MINIMUM = -128;
+constexpr Integral SMALL_INTEGER_MAXIMUM = 1023;
+constexpr unsigned int NUMBER_SMALL_CHARACTERS = 256;
+#endif /* TARGET_6502 */
+
+constexpr unsigned int NUMBER_IMMORTAL_CONSTANTS = 4;
+constexpr unsigned int NUMBER_IMMORTAL_NODES = NUMBER_IMMORTAL_CONSTANTS + NUMBER_BASIC_OPERATORS + NUMBER_SMALL_CHARACTERS + (SMALL_INTEGER_MAXIMUM - SMALL_INTEGER_MINIMUM + 1);
+
+// Strings shorter than this (leaving room for the terminator) are kept inside the node
+constexpr size_t SHORT_STRING_SIZE = (sizeof(Integral) > sizeof(char *) ? sizeof(Integral) : sizeof(char *));
+
 struct LispNode {
 	LispType type;
 
 	union {
 		char *data;
+		Symbol *symbol;
+		Local *local;
+		Bytecode *code;
+		Vector *vector;
+		HashMap *hash_map;
 		Integral number_i;
 		Real number_r;
+		Bignum *bignum;
 		BoxRC head;
+		char short_string[SHORT_STRING_SIZE];
 	};
 
+	static LispNode *immortal_nodes;
+
 public:
 	LispNode(LispType type);
 	~LispNode();
 
+	static void init();
+
+	// Never freed nor reference counted
+	static bool is_immortal(const LispNode *node) {
+		return (reinterpret_cast<uintptr_t>(node) - reinterpret_cast<uintptr_t>(immortal_nodes) < NUMBER_IMMORTAL_NODES * sizeof(LispNode));
+	}
+
 	static void *operator new(size_t size);
 	static void operator delete(void *pointer) noexcept;
 
 	static LispNode *make_data(LispType type, void *data);
+	static LispNode *make_symbol(const char *name);
+	static LispNode *make_local(const LispNodeRC &symbol, unsigned int offset);
+	static LispNode *make_immortal(LispType type);
+	static LispNode *make_operator(int operation_index);
 	static LispNode *make_integer(Integral number_i);
-	static LispNode *make_real(Integral number_i);
+	static LispNode *make_character(Integral number_i);
+	static LispNode *make_real(Real number_r);
+#ifdef BIGNUMS
+	static LispNode *make_bignum(Bignum *bignum);
+#endif /* BIGNUMS */
 	static LispNode *make_list(Box *head = nullptr);
+	static LispNode *make_string(size_t length);
+	static LispNode *make_string(const char *characters);
+#ifdef VECTORS
+	// Returns nullptr if there is no memory for the items
+	static LispNode *make_vector(unsigned int length, const LispNodeRC &fill);
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+	static LispNode *make_hash_map();
+#endif /* HASH_TABLES */
 
 	Box *get_head_pointer() const {
 		return head.get_pointer();
 	}
 
+	// Characters of a string (of either representation), always null-terminated
+	char *get_string() {
+		return (type == LispType::AtomShortString ? short_string : data);
+	}
+
+	const char *get_string() const {
+		return (type == LispType::AtomShortString ? short_string : data);
+	}
+
+	size_t get_string_length() const;
+
 	bool operator==(const LispNode &other) const;
 
 	bool is_atom() const;
@@ -68,20 +147,27 @@ public:
 	bool is_numeric() const;
 	bool is_numeric_integral() const;
 	bool is_numeric_real() const;
+	bool is_numeric_big() const;
 	bool is_data() const;
+	bool is_local() const;
+	bool is_code() const;
+	bool is_vector() const;
+	bool is_hash_map() const;
 
 	bool is_operation(int operator_index) const;
 
-	void op_arithmetic(int operation, LispNodeRC &first, LispNodeRC &second);
-	bool op_comparison(int operation, LispNodeRC &other);
-
-	void op_arithmetic_integer(int operation, LispNodeRC &first, LispNodeRC &second);
-	void op_arithmetic_real(int operation, LispNodeRC &first, LispNodeRC &second);
-	bool op_comparison_integer(int operation, LispNodeRC &other);
-	bool op_comparison_real(int operation, LispNodeRC &other);
+	static bool op_arithmetic_integer(int operation, Integral first, Integral second, Integral &result);
+	static Real op_arithmetic_real(int operation, Real first, Real second);
+#ifdef BIGNUMS
+	static Bignum *op_arithmetic_big(int operation, const Bignum &first, const Bignum &second);
+#endif /* BIGNUMS */
+	static bool op_comparison_integer(int operation, Integral first, Integral second);
+	static bool op_comparison_real(int operation, Real first, Real second);
 
-	void promoteReal();
-	void demoteReal();
+	Real get_real() const;
+#ifdef BIGNUMS
+	Bignum get_bignum() const;
+#endif /* BIGNUMS */
 
 	void print() const;
 };
@@ -101,4 +187,26 @@ struct Box {
 	}
 };
 
+// Reference to a local variable, resolved to its offset in the environment
+
+struct Local {
+	LispNodeRC symbol;
+	unsigned int offset;
+
+	Local(const LispNodeRC &symbol, unsigned int offset);
+};
+
+#ifdef VECTORS
+// Items of a vector, stored contiguously for constant-time indexing
+
+struct Vector {
+	LispNodeRC *items;
+	unsigned int length;
+
+	// Leaves items as nullptr if there is no memory for them
+	Vector(unsigned int length, const LispNodeRC &fill);
+	~Vector();
+};
+#endif /* VECTORS */
+
 #endif /* LISP_NODE_H */
\ No newline at end of file
@@ -3,20 +3,56 @@
 
 #include "LispNode.h"
 
+#ifdef CYCLE_COLLECTOR
+#include "CycleCollector.h"
+#endif /* CYCLE_COLLECTOR */
+
 #ifdef REFERENCE_COUNTING
+// Immortal nodes have no counter
+static inline bool is_counted(const LispNode *pointer) {
+    return !LispNode::is_immortal(pointer);
+}
+
+static inline bool is_counted(const Box *) {
+    return true;
+}
+
+#ifdef CYCLE_COLLECTOR
+// Only these can be in a cycle the symbol table does not reach
+static inline bool is_cycle_candidate(const LispNode *pointer) {
+    return (pointer->type == LispType::List || pointer->type == LispType::AtomCode || pointer->type == LispType::AtomVector || pointer->type == LispType::AtomHashMap);
+}
+
+static inline bool is_cycle_candidate(const Box *) {
+    return true;
+}
+#endif /* CYCLE_COLLECTOR */
+
 template<typename T>
 void RCPointer<T>::set(T *pointer_new) noexcept {
-    if(pointer_new) {
+    if(pointer_new && is_counted(pointer_new)) {
         CounterType *reference_counter_new = ((CounterType *) pointer_new) - 1;
         (*reference_counter_new)++;
     }
 
-    if(pointer) {
+    if(pointer && is_counted(pointer)) {
         CounterType *reference_counter = ((CounterType *) pointer) - 1;
 
+#ifdef CYCLE_COLLECTOR
+        // Candidates are left for the cycle collector to free, unless they are taken back
+        if((--(*reference_counter) & CycleCollector::COUNT_MASK) == 0) {
+            if(!(*reference_counter & CycleCollector::BUFFERED) || CycleCollector::remove_candidate(pointer)) {
+                Allocator<T>::enqueue_for_deletion(pointer);
+            }
+        }
+        else if(!(*reference_counter & CycleCollector::BUFFERED) && is_cycle_candidate(pointer)) {
+            CycleCollector::add_candidate(pointer);
+        }
+#else
         if(--(*reference_counter) == 0) {
             Allocator<T>::enqueue_for_deletion(pointer);
         }
+#endif /* CYCLE_COLLECTOR */
     }
 
     pointer = pointer_new;
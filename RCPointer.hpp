@@ -6,6 +6,10 @@
 
 #include "types.h"
 
+#ifdef GENERATIONAL
+#include "SimpleAllocator.h"
+#endif /* GENERATIONAL */
+
 template<typename T>
 class RCPointer {
 private:
@@ -25,6 +29,9 @@ public:
 
     RCPointer(RCPointer &&other) noexcept: pointer{other.pointer} {
         other.pointer = nullptr;
+#ifdef GENERATIONAL
+        remember();
+#endif /* GENERATIONAL */
     }
 
     RCPointer &operator=(T *other_pointer) {
@@ -53,6 +60,9 @@ public:
 
             pointer = other.pointer;
             other.pointer = nullptr;
+#ifdef GENERATIONAL
+            remember();
+#endif /* GENERATIONAL */
         }
 
         return *this;
@@ -96,8 +106,20 @@ private:
 #else
     inline void set(T *pointer_new) noexcept {
         pointer = pointer_new;
+#ifdef GENERATIONAL
+        remember();
+#endif /* GENERATIONAL */
     }
 #endif /* REFERENCE_COUNTING */
+
+#ifdef GENERATIONAL
+    // Write barrier: old objects pointing into the nursery are roots for the next young collection
+    inline void remember() noexcept {
+        if(SimpleAllocator::is_young(pointer) && SimpleAllocator::is_old(this)) {
+            SimpleAllocator::remember(this, AllocationIndexOf<T>::value);
+        }
+    }
+#endif /* GENERATIONAL */
 };
 
 #endif /* RCPOINTER_HPP */
@@ -0,0 +1,69 @@
+#ifndef SEGMENTEDSTACK_HPP
+#define SEGMENTEDSTACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Stack storage made of fixed-size segments, allocated as the stack grows
+//
+// Segments never move once allocated, so references to entries stay valid
+// while the stack grows. The caller keeps the top index, and asks for a new
+// segment only when it reaches the end of the allocated ones.
+template<typename T, unsigned int SEGMENT_BITS>
+class SegmentedStack {
+public:
+    constexpr static unsigned int SEGMENT_SIZE = 1u << SEGMENT_BITS;
+
+private:
+    T **segments;
+
+    unsigned int number_segments;
+    unsigned int maximum_segments;
+
+public:
+    SegmentedStack(): segments{nullptr}, number_segments{0}, maximum_segments{0} {
+    }
+
+    ~SegmentedStack() {
+        shrink(0);
+
+        delete[] segments;
+    }
+
+    void init(unsigned int maximum_segments) {
+        this->maximum_segments = maximum_segments;
+
+        segments = new T*[maximum_segments];
+        number_segments = 0;
+
+        grow();
+    }
+
+    inline T &operator[](unsigned int index) {
+        return segments[index >> SEGMENT_BITS][index & (SEGMENT_SIZE - 1)];
+    }
+
+    inline unsigned int capacity() const {
+        return number_segments << SEGMENT_BITS;
+    }
+
+    // Returns false if the stack is already at its maximum size
+    bool grow() {
+        if(number_segments == maximum_segments) {
+            return false;
+        }
+
+        segments[number_segments++] = new T[SEGMENT_SIZE];
+
+        return true;
+    }
+
+    // Releases the segments past the first ones
+    void shrink(unsigned int kept_segments) {
+        while(number_segments > kept_segments) {
+            delete[] segments[--number_segments];
+        }
+    }
+};
+
+#endif /* SEGMENTEDSTACK_HPP */
@@ -1,78 +1,153 @@
 #include <new>
-#include <stdio.h>
+#include <stdlib.h>
 
 #include "SimpleAllocator.h"
 
+#include "LispNode.h"
+
 static constexpr uint8_t NUMBER_STANDARD_ALLOCATIONS = 2;
 
-#ifdef REFERENCE_COUNTING
-static constexpr uint8_t STANDARD_ALLOCATIONS[NUMBER_STANDARD_ALLOCATIONS] = {
+// Slots keep the reference counter right before the object, as laid out by Allocator<T>
+static constexpr size_t STANDARD_ALLOCATIONS[NUMBER_STANDARD_ALLOCATIONS] = {
 	(sizeof(LispNode) + sizeof(CounterType)),
 	(sizeof(Box) + sizeof(CounterType))
 };
+
+// Chunks are aligned to their size, which must be a power of two, and are taken from
+// the system a block at a time (aligned allocations leave gaps, which are paid once per block)
+#ifdef TARGET_6502
+static constexpr size_t CHUNK_BYTES = 512;
+static constexpr unsigned int CHUNKS_PER_BLOCK = 4;
 #else
-static constexpr uint8_t STANDARD_ALLOCATIONS[NUMBER_STANDARD_ALLOCATIONS] = {
-	sizeof(LispNode),
-	sizeof(Box)
-};
-#endif /* REFERENCE_COUNTING */
+static constexpr size_t CHUNK_BYTES = 4096;
+static constexpr unsigned int CHUNKS_PER_BLOCK = 16;
+#endif /* TARGET_6502 */
+
+static_assert((CHUNK_BYTES & (CHUNK_BYTES - 1)) == 0, "Chunk size must be a power of two");
+
+static constexpr size_t BLOCK_BYTES = CHUNK_BYTES * CHUNKS_PER_BLOCK;
+
+#ifdef GENERATIONAL
+#ifdef TARGET_6502
+static constexpr size_t NURSERY_BYTES = 1024;
+#else
+static constexpr size_t NURSERY_BYTES = 262144;
+#endif /* TARGET_6502 */
+
+// Address space reserved for the old generation (only the blocks in use take memory on most systems)
+#ifndef OLD_GENERATION_SIZE
+#ifdef TARGET_6502
+#define OLD_GENERATION_SIZE 8192
+#else
+#define OLD_GENERATION_SIZE (sizeof(void *) >= 8 ? (size_t(1) << 30) : (size_t(1) << 26))
+#endif /* TARGET_6502 */
+#endif /* OLD_GENERATION_SIZE */
 
-static constexpr uint8_t CHUNK_SIZE = 128;
+static constexpr size_t OLD_GENERATION_BYTES = (OLD_GENERATION_SIZE / BLOCK_BYTES) * BLOCK_BYTES;
+
+#ifdef TARGET_6502
+static constexpr unsigned int INITIAL_REMEMBERED_CAPACITY = 16;
+#else
+static constexpr unsigned int INITIAL_REMEMBERED_CAPACITY = 256;
+#endif /* TARGET_6502 */
+#endif /* GENERATIONAL */
+
+// Upper bound on the slots of a chunk, which sizes the bitmaps
+static constexpr unsigned int MAXIMUM_CHUNK_SLOTS = 256;
 
 struct Chunk {
+	// Free list threaded through the free slots
 	char *next;
-	char *start;
-	char *limit;
-	uint8_t number_free;
+	unsigned int number_free;
+
 	AllocationIndex allocation_index;
 
-	char bitmap[CHUNK_SIZE / 8];
-	char bitmap2[CHUNK_SIZE / 8];
+	// All chunks of an allocation index, and the ones among them with free slots
+	Chunk *previous_chunk;
+	Chunk *next_chunk;
+
+	Chunk *previous_free;
+	Chunk *next_free;
+
+	// Allocated slots, and slots marked by the GC
+	uint8_t bitmap[MAXIMUM_CHUNK_SLOTS / 8];
+	uint8_t bitmap2[MAXIMUM_CHUNK_SLOTS / 8];
 
 	Chunk(AllocationIndex allocation_index);
-	~Chunk();
 
-	Chunk *next_chunk;
+	// Slots start right after the header, in the same aligned block
+	char *get_start() {
+		return reinterpret_cast<char *>(this + 1);
+	}
 };
 
-void BITMAP_CLEAR(char *bitmap) {
-	for(auto i = 0; i < CHUNK_SIZE / 8; i++) {
+static constexpr unsigned int get_number_slots(size_t allocation_size) {
+	return ((CHUNK_BYTES - sizeof(Chunk)) / allocation_size < MAXIMUM_CHUNK_SLOTS) ? (CHUNK_BYTES - sizeof(Chunk)) / allocation_size : MAXIMUM_CHUNK_SLOTS;
+}
+
+static constexpr unsigned int CHUNK_SLOTS[NUMBER_STANDARD_ALLOCATIONS] = {
+	get_number_slots(STANDARD_ALLOCATIONS[0]),
+	get_number_slots(STANDARD_ALLOCATIONS[1])
+};
+
+static_assert(STANDARD_ALLOCATIONS[0] >= sizeof(char *) && STANDARD_ALLOCATIONS[1] >= sizeof(char *), "Free slots must hold a pointer");
+static_assert(CHUNK_SLOTS[0] > 0 && CHUNK_SLOTS[1] > 0, "Chunks must hold at least one slot");
+
+void BITMAP_CLEAR(uint8_t *bitmap) {
+	for(unsigned int i = 0; i < MAXIMUM_CHUNK_SLOTS / 8; i++) {
 		bitmap[i] = 0;
 	}
 }
 
-bool BITMAP_GET(char *bitmap, uint8_t offset) {
+bool BITMAP_GET(uint8_t *bitmap, unsigned int offset) {
 	return (bitmap[(offset) / 8] & (1U << ((offset) % 8)));
 }
 
-void BITMAP_SET_ON(char *bitmap, uint8_t offset) {
+void BITMAP_SET_ON(uint8_t *bitmap, unsigned int offset) {
 	bitmap[(offset) / 8] |= (1U << ((offset) % 8));
 }
 
-void BITMAP_SET_OFF(char *bitmap, uint8_t offset) {
+void BITMAP_SET_OFF(uint8_t *bitmap, unsigned int offset) {
 	bitmap[(offset) / 8] &= ~(1U << ((offset) % 8));
 }
 
 static Chunk *chunks[NUMBER_STANDARD_ALLOCATIONS];
+static Chunk *free_chunks[NUMBER_STANDARD_ALLOCATIONS];
 
-int find_position(Chunk *chunk, void *pointer) {
-	return (reinterpret_cast<char *>(pointer) - chunk->start) / STANDARD_ALLOCATIONS[chunk->allocation_index];
-}
+// Empty chunks, reused by any allocation index, and the rest of the last block taken
+static Chunk *spare_chunks;
 
-Chunk *find_chunk(void *pointer, int *position) {
-	for(uint8_t i = 0; i < NUMBER_STANDARD_ALLOCATIONS; i++) {
-		for(Chunk *current = chunks[i]; current != nullptr; current = current->next_chunk) {
-			if(current->start <= pointer && pointer < current->limit) {
-				if(position != nullptr) {
-					*position = find_position(current, pointer);
-				}
+static char *block_next;
+static unsigned int block_remaining;
 
-				return current;
-			}
-		}
-	}
+unsigned long SimpleAllocator::number_allocated = 0;
+
+#ifdef GENERATIONAL
+char *SimpleAllocator::nursery_start = nullptr;
+char *SimpleAllocator::nursery_next = nullptr;
+char *SimpleAllocator::nursery_end = nullptr;
+
+char *SimpleAllocator::old_start = nullptr;
+char *SimpleAllocator::old_end = nullptr;
+
+bool SimpleAllocator::young_collection_due = false;
+bool SimpleAllocator::remembered_lost = false;
 
-	return nullptr;
+void **SimpleAllocator::remembered[IndexGeneric];
+unsigned int SimpleAllocator::number_remembered[IndexGeneric];
+
+static unsigned int remembered_capacity[IndexGeneric];
+
+// Blocks not yet taken from the old generation start here
+static char *old_next;
+#endif /* GENERATIONAL */
+
+inline Chunk *find_chunk(void *pointer) {
+	return reinterpret_cast<Chunk *>(reinterpret_cast<uintptr_t>(pointer) & ~static_cast<uintptr_t>(CHUNK_BYTES - 1));
+}
+
+inline unsigned int find_position(Chunk *chunk, void *pointer) {
+	return (reinterpret_cast<char *>(pointer) - chunk->get_start()) / STANDARD_ALLOCATIONS[chunk->allocation_index];
 }
 
 inline void destruct_lispnode(void *pointer) {
@@ -84,14 +159,13 @@ inline void destruct_box(void *pointer) {
 }
 
 Chunk::Chunk(AllocationIndex allocation_index): allocation_index{allocation_index} {
-	int allocation_size = STANDARD_ALLOCATIONS[allocation_index];
+	size_t allocation_size = STANDARD_ALLOCATIONS[allocation_index];
+	unsigned int number_slots = CHUNK_SLOTS[allocation_index];
 
-	char *data = (char *) malloc(CHUNK_SIZE * allocation_size);
+	char *position_curr = get_start();
+	char *position_next = position_curr + allocation_size;
 
-	char *position_curr = data;
-	char *position_next = data + allocation_size;
-
-	for(int i = 0; i < CHUNK_SIZE - 1; i++) {
+	for(unsigned int i = 0; i < number_slots - 1; i++) {
 		*((char **) position_curr) = position_next;
 
 		position_curr = position_next;
@@ -100,59 +174,145 @@ Chunk::Chunk(AllocationIndex allocation_index): allocation_index{allocation_inde
 
 	*((char **) position_curr) = nullptr;
 
-	this->start = data;
-	this->limit = data + (CHUNK_SIZE * allocation_size);
-
-	this->next = data;
-	this->number_free = CHUNK_SIZE;
+	this->next = get_start();
+	this->number_free = number_slots;
 
+	this->previous_chunk = nullptr;
 	this->next_chunk = nullptr;
 
+	this->previous_free = nullptr;
+	this->next_free = nullptr;
+
 	BITMAP_CLEAR(this->bitmap);
+	BITMAP_CLEAR(this->bitmap2);
 }
 
-Chunk::~Chunk() {
-	free(this->start);
+// Chunk lists are doubly linked, so chunks leave them in constant time
+
+void link_chunk(Chunk *chunk) {
+	AllocationIndex allocation_index = chunk->allocation_index;
+
+	chunk->previous_chunk = nullptr;
+	chunk->next_chunk = chunks[allocation_index];
+
+	if(chunks[allocation_index] != nullptr) {
+		chunks[allocation_index]->previous_chunk = chunk;
+	}
+
+	chunks[allocation_index] = chunk;
 }
 
-void SimpleAllocator::init() {
-	chunks[0] = new Chunk(AllocationIndex::IndexLispNode);
-	chunks[1] = new Chunk(AllocationIndex::IndexBox);
+void unlink_chunk(Chunk *chunk) {
+	if(chunk->previous_chunk != nullptr) {
+		chunk->previous_chunk->next_chunk = chunk->next_chunk;
+	}
+	else {
+		chunks[chunk->allocation_index] = chunk->next_chunk;
+	}
+
+	if(chunk->next_chunk != nullptr) {
+		chunk->next_chunk->previous_chunk = chunk->previous_chunk;
+	}
 }
 
-void SimpleAllocator::finish() {
-	Chunk *previous_chunk;
+void link_free(Chunk *chunk) {
+	AllocationIndex allocation_index = chunk->allocation_index;
 
-	for(uint8_t i = 0; i < NUMBER_STANDARD_ALLOCATIONS; i++) {
-		while(chunks[i]) {
-			previous_chunk = chunks[i];
-			chunks[i] = chunks[i]->next_chunk;
+	chunk->previous_free = nullptr;
+	chunk->next_free = free_chunks[allocation_index];
 
-			delete previous_chunk;
-		}
+	if(free_chunks[allocation_index] != nullptr) {
+		free_chunks[allocation_index]->previous_free = chunk;
 	}
+
+	free_chunks[allocation_index] = chunk;
 }
 
-void *SimpleAllocator::allocate(int size, AllocationIndex allocation_index) {
-	if(allocation_index < AllocationIndex::IndexGeneric) {
-		Chunk *used_chunk = nullptr;
+void unlink_free(Chunk *chunk) {
+	if(chunk->previous_free != nullptr) {
+		chunk->previous_free->next_free = chunk->next_free;
+	}
+	else {
+		free_chunks[chunk->allocation_index] = chunk->next_free;
+	}
+
+	if(chunk->next_free != nullptr) {
+		chunk->next_free->previous_free = chunk->previous_free;
+	}
+}
+
+char *allocate_block() {
+#ifdef GENERATIONAL
+	if(static_cast<size_t>(SimpleAllocator::old_end - old_next) < BLOCK_BYTES) {
+		return nullptr;
+	}
+
+	char *result = old_next;
+	old_next += BLOCK_BYTES;
+
+	return result;
+#else
+	return (char *) aligned_alloc(CHUNK_BYTES, BLOCK_BYTES);
+#endif /* GENERATIONAL */
+}
+
+Chunk *create_chunk(AllocationIndex allocation_index) {
+	void *memory;
 
-		// Try to find a chunk with free space
-		for(Chunk *current = chunks[allocation_index]; current != nullptr; current = current->next_chunk) {
-			if(current->next != nullptr) {
-				used_chunk = current;
-				break;
+	if(spare_chunks != nullptr) {
+		memory = spare_chunks;
+		spare_chunks = spare_chunks->next_chunk;
+	}
+	else {
+		if(block_remaining == 0) {
+			if((block_next = allocate_block()) == nullptr) {
+				return nullptr;
 			}
+
+			block_remaining = CHUNKS_PER_BLOCK;
 		}
 
-		// If a chunk is not found, allocate one and use it
-		if(used_chunk == nullptr) {
-			Chunk *new_chunk = new Chunk(allocation_index);
+		memory = block_next;
+
+		block_next += CHUNK_BYTES;
+		block_remaining--;
+	}
+
+	Chunk *chunk = new (memory) Chunk(allocation_index);
+
+	link_chunk(chunk);
+	link_free(chunk);
+
+	return chunk;
+}
+
+// Moves an empty chunk to the spare ones, unless it is the only one with free slots (so that
+// allocating and deallocating around a chunk boundary does not move chunks over and over)
+void release_if_empty(Chunk *chunk) {
+	if(chunk->number_free < CHUNK_SLOTS[chunk->allocation_index]) {
+		return;
+	}
+
+	if(free_chunks[chunk->allocation_index] == chunk && chunk->next_free == nullptr) {
+		return;
+	}
 
-			new_chunk->next_chunk = chunks[allocation_index];
-			chunks[allocation_index] = new_chunk;
+	unlink_free(chunk);
+	unlink_chunk(chunk);
 
-			used_chunk = new_chunk;
+	chunk->next_chunk = spare_chunks;
+	spare_chunks = chunk;
+}
+
+void *SimpleAllocator::allocate(size_t size, AllocationIndex allocation_index) {
+	if(allocation_index < AllocationIndex::IndexGeneric) {
+		Chunk *used_chunk = free_chunks[allocation_index];
+
+		// If no chunk has free space, allocate one and use it
+		if(used_chunk == nullptr) {
+			if((used_chunk = create_chunk(allocation_index)) == nullptr) {
+				return nullptr;
+			}
 		}
 
 		// Allocate memory within the used chunk
@@ -161,36 +321,47 @@ void *SimpleAllocator::allocate(int size, AllocationIndex allocation_index) {
 		used_chunk->next = *((char **) result);
 		used_chunk->number_free--;
 
+		if(used_chunk->number_free == 0) {
+			unlink_free(used_chunk);
+		}
+
 		BITMAP_SET_ON(used_chunk->bitmap, find_position(used_chunk, result));
+		number_allocated++;
+
 		return result;
 	}
 
-	return malloc(size);
+	return Allocate(size);
 }
 
-void do_deallocate(Chunk *chunk, void *pointer, int position) {
+void do_deallocate(Chunk *chunk, void *pointer, unsigned int position) {
 	BITMAP_SET_OFF(chunk->bitmap, position);
 
 	// Add the pointer back to the free list on the used chunk
 	*((char **) pointer) = chunk->next;
 
 	chunk->next = (char *) pointer;
-	chunk->number_free++;
+	SimpleAllocator::number_allocated--;
+
+	if(chunk->number_free++ == 0) {
+		link_free(chunk);
+	}
 }
 
-void SimpleAllocator::deallocate(void *pointer) {
-	Chunk *chunk;
-	int position;
+void SimpleAllocator::deallocate(void *pointer, AllocationIndex allocation_index) {
+	if(allocation_index < AllocationIndex::IndexGeneric) {
+		Chunk *chunk = find_chunk(pointer);
+		unsigned int position = find_position(chunk, pointer);
 
-	if((chunk = find_chunk(pointer, &position))) {
 		if(BITMAP_GET(chunk->bitmap, position)) {
 			do_deallocate(chunk, pointer, position);
+			release_if_empty(chunk);
 		}
 
 		return;
 	}
 
-	free(pointer);
+	Deallocate(pointer);
 }
 
 void SimpleAllocator::setup() {
@@ -202,59 +373,102 @@ void SimpleAllocator::setup() {
 }
 
 void SimpleAllocator::set_mark(void *pointer) {
-	Chunk *chunk;
-	int position;
-
-#ifdef REFERENCE_COUNTING
 	pointer = reinterpret_cast<char *>(pointer) - sizeof(CounterType);
-#endif /* REFERENCE_COUNTING */
 
-	if((chunk = find_chunk(pointer, &position))) {
-		BITMAP_SET_ON(chunk->bitmap2, position);
-	}
+	Chunk *chunk = find_chunk(pointer);
+	BITMAP_SET_ON(chunk->bitmap2, find_position(chunk, pointer));
 }
 
 bool SimpleAllocator::get_mark(void *pointer) {
-	Chunk *chunk;
-	int position;
-
-#ifdef REFERENCE_COUNTING
 	pointer = reinterpret_cast<char *>(pointer) - sizeof(CounterType);
-#endif /* REFERENCE_COUNTING */
-
-	if((chunk = find_chunk(pointer, &position))) {
-		return BITMAP_GET(chunk->bitmap2, position);
-	}
 
-	return true;
+	Chunk *chunk = find_chunk(pointer);
+	return BITMAP_GET(chunk->bitmap2, find_position(chunk, pointer));
 }
 
 void SimpleAllocator::commit() {
 	for(uint8_t i = 0; i < NUMBER_STANDARD_ALLOCATIONS; i++) {
-		for(Chunk *current = chunks[i]; current != nullptr; current = current->next_chunk) {
-			for(size_t position = 0; position < CHUNK_SIZE; position++) {
+		Chunk *next_chunk;
+
+		for(Chunk *current = chunks[i]; current != nullptr; current = next_chunk) {
+			next_chunk = current->next_chunk;
+
+			for(unsigned int position = 0; position < CHUNK_SLOTS[i]; position++) {
 				if(!BITMAP_GET(current->bitmap, position) || BITMAP_GET(current->bitmap2, position)) {
 					continue;
 				}
 
-				void *pointer = current->start + (position * STANDARD_ALLOCATIONS[current->allocation_index]);
-#ifdef REFERENCE_COUNTING
+				void *pointer = current->get_start() + (position * STANDARD_ALLOCATIONS[i]);
 				void *object_location = reinterpret_cast<char *>(pointer) + sizeof(CounterType);
-#else
-				void *object_location = pointer;
-#endif /* REFERENCE_COUNTING */
 
-				if(current->allocation_index == 0) {
-					// ((LispNode *) object_location)->print();
+				if(i == IndexLispNode) {
 					destruct_lispnode(object_location);
 				}
 				else {
-					// ((Box *) object_location)->item->print();
 					destruct_box(object_location);
 				}
 
 				do_deallocate(current, pointer, position);
 			}
+
+			release_if_empty(current);
 		}
 	}
-}
\ No newline at end of file
+}
+
+#ifdef GENERATIONAL
+void SimpleAllocator::init() {
+	if((nursery_start = (char *) Allocate(NURSERY_BYTES)) != nullptr) {
+		nursery_next = nursery_start;
+		nursery_end = nursery_start + NURSERY_BYTES;
+	}
+
+	if((old_start = (char *) aligned_alloc(CHUNK_BYTES, OLD_GENERATION_BYTES)) != nullptr) {
+		old_next = old_start;
+		old_end = old_start + OLD_GENERATION_BYTES;
+	}
+}
+
+void SimpleAllocator::remember(void *slot, AllocationIndex allocation_index) {
+	unsigned int &count = number_remembered[allocation_index];
+
+	// Repeated stores to the same slot are remembered once
+	if(count > 0 && remembered[allocation_index][count - 1] == slot) {
+		return;
+	}
+
+	if(count == remembered_capacity[allocation_index]) {
+		unsigned int new_capacity = (count == 0 ? INITIAL_REMEMBERED_CAPACITY : count * 2);
+		void **new_remembered = (void **) Allocate(new_capacity * sizeof(void *));
+
+		if(new_remembered == nullptr) {
+			remembered_lost = true;
+			young_collection_due = true;
+
+			return;
+		}
+
+		for(unsigned int i = 0; i < count; i++) {
+			new_remembered[i] = remembered[allocation_index][i];
+		}
+
+		Deallocate(remembered[allocation_index]);
+
+		remembered[allocation_index] = new_remembered;
+		remembered_capacity[allocation_index] = new_capacity;
+	}
+
+	remembered[allocation_index][count++] = slot;
+}
+
+void SimpleAllocator::reset_nursery() {
+	nursery_next = nursery_start;
+
+	for(uint8_t i = 0; i < NUMBER_STANDARD_ALLOCATIONS; i++) {
+		number_remembered[i] = 0;
+	}
+
+	young_collection_due = false;
+	remembered_lost = false;
+}
+#endif /* GENERATIONAL */
@@ -1,8 +1,10 @@
 #ifndef SIMPLE_ALLOCATOR_H
 #define SIMPLE_ALLOCATOR_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "types.h"
-#include "LispNode.h"
 
 enum AllocationIndex : uint8_t {
 	IndexLispNode = 0,
@@ -10,19 +12,92 @@ enum AllocationIndex : uint8_t {
 	IndexGeneric = 2
 };
 
+// Slab allocator for the fixed-size objects (LispNode and Box, each with its reference counter)
+//
+// Chunks are aligned to their own size, so masking a slot address gives its chunk, and the chunks
+// with free slots are kept in a list: both allocation and deallocation take constant time.
+// Empty chunks are kept for reuse by either type. Other sizes go to Allocate/Deallocate.
+
 struct SimpleAllocator {
-	static void init();
-	static void finish();
+	// Objects allocated from chunks, of every allocation index
+	static unsigned long number_allocated;
 
-	static void *allocate(int size, AllocationIndex allocation_index = IndexGeneric);
-	static void deallocate(void *pointer);
+	static void *allocate(size_t size, AllocationIndex allocation_index = IndexGeneric);
+	static void deallocate(void *pointer, AllocationIndex allocation_index = IndexGeneric);
 
-	// Mark-and-sweep GC functions
+	// Mark-and-sweep GC functions (pointers are to objects allocated here, after their reference counters)
 
 	static void setup();
 	static void set_mark(void *pointer);
 	static bool get_mark(void *pointer);
 	static void commit();
+
+#ifdef GENERATIONAL
+	// Generational heap: new objects are bumped from the nursery, and the ones surviving a collection
+	// are copied into chunks, all carved from a single reserved region (the old generation)
+
+	static char *nursery_start;
+	static char *nursery_next;
+	static char *nursery_end;
+
+	static char *old_start;
+	static char *old_end;
+
+	// Set when the nursery runs out, and when a remembered slot could not be recorded
+	static bool young_collection_due;
+	static bool remembered_lost;
+
+	// Slots in old objects made to point into the nursery since the last collection, by the type they point to
+	static void **remembered[IndexGeneric];
+	static unsigned int number_remembered[IndexGeneric];
+
+	static void init();
+
+	// Returns nullptr if the nursery is full (making a collection due, unless it is empty)
+	static void *allocate_young(size_t size) {
+		if(static_cast<size_t>(nursery_end - nursery_next) < size) {
+			young_collection_due = (nursery_next != nursery_start);
+
+			return nullptr;
+		}
+
+		void *result = nursery_next;
+		nursery_next += size;
+
+		return result;
+	}
+
+	static bool is_young(const void *pointer) {
+		return (reinterpret_cast<uintptr_t>(pointer) - reinterpret_cast<uintptr_t>(nursery_start) < static_cast<uintptr_t>(nursery_end - nursery_start));
+	}
+
+	static bool is_old(const void *address) {
+		return (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(old_start) < static_cast<uintptr_t>(old_end - old_start));
+	}
+
+	static void remember(void *slot, AllocationIndex allocation_index);
+
+	// Empties the nursery (after its survivors were copied) and forgets the remembered slots
+	static void reset_nursery();
+#endif /* GENERATIONAL */
+};
+
+// Allocation index used by Allocator<T>
+
+struct LispNode;
+struct Box;
+
+template<typename T>
+struct AllocationIndexOf;
+
+template<>
+struct AllocationIndexOf<LispNode> {
+	static constexpr AllocationIndex value = IndexLispNode;
+};
+
+template<>
+struct AllocationIndexOf<Box> {
+	static constexpr AllocationIndex value = IndexBox;
 };
 
-#endif /* SIMPLE_ALLOCATOR_H */
\ No newline at end of file
+#endif /* SIMPLE_ALLOCATOR_H */
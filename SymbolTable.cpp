@@ -0,0 +1,97 @@
+#include "SymbolTable.h"
+
+#include "extra.h"
+
+#ifdef MARK_AND_SWEEP
+#include "GarbageCollector.h"
+#endif /* MARK_AND_SWEEP */
+
+#ifdef TARGET_6502
+static constexpr size_t INITIAL_CAPACITY = 32;
+#else
+static constexpr size_t INITIAL_CAPACITY = 256;
+#endif /* TARGET_6502 */
+
+// Open addressing with linear probing (capacity is always a power of two)
+static LispNodeRC *table;
+
+static size_t capacity;
+static size_t count;
+
+Symbol::Symbol(const char *name): name{strdup(name)}, value{nullptr} {
+}
+
+Symbol::~Symbol() {
+	free(name);
+}
+
+static size_t find_slot(LispNodeRC *slots, size_t slots_capacity, const char *name) {
+	size_t position = hash_string(name) & (slots_capacity - 1);
+
+	while(slots[position] != nullptr && strcmp(slots[position]->symbol->name, name) != 0) {
+		position = (position + 1) & (slots_capacity - 1);
+	}
+
+	return position;
+}
+
+static void grow() {
+	size_t new_capacity = capacity * 2;
+	LispNodeRC *new_table = new LispNodeRC[new_capacity];
+
+	for(size_t i = 0; i < capacity; i++) {
+		if(table[i] != nullptr) {
+			new_table[find_slot(new_table, new_capacity, table[i]->symbol->name)] = table[i];
+		}
+	}
+
+	delete[] table;
+
+	table = new_table;
+	capacity = new_capacity;
+}
+
+void SymbolTable::init() {
+	table = new LispNodeRC[INITIAL_CAPACITY];
+
+	capacity = INITIAL_CAPACITY;
+	count = 0;
+}
+
+void SymbolTable::finish() {
+	delete[] table;
+
+	table = nullptr;
+
+	capacity = 0;
+	count = 0;
+}
+
+LispNode *SymbolTable::intern(const char *name) {
+	size_t position = find_slot(table, capacity, name);
+
+	if(table[position] != nullptr) {
+		return table[position].get_pointer();
+	}
+
+	LispNode *symbol = new LispNode(LispType::AtomPure);
+	symbol->symbol = new Symbol(name);
+
+	table[position] = symbol;
+	count++;
+
+	// Keep the load factor under 3/4 so probe sequences stay short
+	if(4 * count >= 3 * capacity) {
+		grow();
+	}
+
+	return symbol;
+}
+
+#ifdef MARK_AND_SWEEP
+void SymbolTable::mark() {
+	for(size_t i = 0; i < capacity; i++) {
+		GarbageCollector::mark(table[i]);
+	}
+}
+#endif /* MARK_AND_SWEEP */
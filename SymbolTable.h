@@ -0,0 +1,32 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include "LispNode.h"
+
+// Each pure atom points to its symbol, which also works as the value cell
+// for the global (top-level) binding of that name
+
+struct Symbol {
+	char *name;
+	LispNodeRC value;
+
+	Symbol(const char *name);
+	~Symbol();
+};
+
+// Interns pure atoms: each distinct name is represented by exactly one LispNode,
+// so symbols can be compared by their address instead of by their name
+
+struct SymbolTable {
+	static void init();
+	static void finish();
+
+	static LispNode *intern(const char *name);
+
+#ifdef MARK_AND_SWEEP
+	// Marks every interned symbol, and with them every global binding
+	static void mark();
+#endif /* MARK_AND_SWEEP */
+};
+
+#endif /* SYMBOL_TABLE_H */
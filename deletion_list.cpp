@@ -0,0 +1,64 @@
+#include "deletion_list.h"
+
+#include <cstdlib>
+
+#include "extra.h"
+
+DeletionList::DeletionList(): top{nullptr}, top_count{0}, spare{nullptr} {
+}
+
+DeletionList::~DeletionList() {
+    while(top != nullptr) {
+        Chunk *previous = top->previous;
+
+        Deallocate(top);
+
+        top = previous;
+    }
+
+    if(spare != nullptr) {
+        Deallocate(spare);
+    }
+}
+
+void DeletionList::init() {
+    top = (Chunk *) Allocate(sizeof(Chunk));
+    top->previous = nullptr;
+
+    top_count = 0;
+}
+
+bool DeletionList::grow() {
+    Chunk *chunk = spare;
+
+    if(chunk != nullptr) {
+        spare = nullptr;
+    }
+    else if((chunk = (Chunk *) Allocate(sizeof(Chunk))) == nullptr) {
+        return false;
+    }
+
+    chunk->previous = top;
+
+    top = chunk;
+    top_count = 0;
+
+    return true;
+}
+
+bool DeletionList::shrink() {
+    if(top->previous == nullptr) {
+        return false;
+    }
+
+    if(spare != nullptr) {
+        Deallocate(spare);
+    }
+
+    spare = top;
+
+    top = top->previous;
+    top_count = CHUNK_SIZE;
+
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef DELETION_LIST_H
+#define DELETION_LIST_H
+
+#include <cstddef>
+
+// Objects waiting to be deleted, in a stack of chunks that grows as needed
+class DeletionList {
+public:
+#ifdef TARGET_6502
+    constexpr static size_t CHUNK_SIZE = 32;
+#else
+    constexpr static size_t CHUNK_SIZE = 256;
+#endif /* TARGET_6502 */
+
+private:
+    struct Chunk {
+        Chunk *previous;
+
+        void *pointers[CHUNK_SIZE];
+    };
+
+    Chunk *top;
+    size_t top_count;
+
+    // The last chunk emptied is kept, so a list hovering at a chunk boundary does not reallocate
+    Chunk *spare;
+
+public:
+    DeletionList();
+    ~DeletionList();
+
+    void init();
+
+    // Returns false if there is no memory for another chunk
+    inline bool push(void *pointer) {
+        if(top_count == CHUNK_SIZE && !grow()) {
+            return false;
+        }
+
+        top->pointers[top_count++] = pointer;
+
+        return true;
+    }
+
+    inline void* pop() {
+        if(top_count == 0 && !shrink()) {
+            return nullptr;
+        }
+
+        return top->pointers[--top_count];
+    }
+
+    // More than a chunk of objects waiting
+    inline bool is_long() const {
+        return top->previous != nullptr;
+    }
+
+private:
+    bool grow();
+    bool shrink();
+};
+
+#endif /* DELETION_LIST_H */
@@ -18,40 +18,34 @@ void print_integral(Integral n) {
 void get_integral_string(Integral n, char *buffer) {
     int position = 0;
 
-    if(n == 0) {
-        buffer[position] = '0';
-        position++;
+    // Works on the magnitude, which also holds the most negative value
+    UnsignedIntegral magnitude = static_cast<UnsignedIntegral>(n);
 
-        buffer[position] = '\0';
-        return;
-    }
-    
     if(n < 0) {
         buffer[position] = '-';
         position++;
 
-        n = -n;
+        magnitude = 0 - magnitude;
     }
-    
-    Integral reversed = 0;
-    int digit_count = 0;
-    
-    while(n > 0) {
-        reversed = (reversed * 10) + (n % 10);
-        n /= 10;
-
-        digit_count++;
-    }
-    
-    while(digit_count--) {
-        buffer[position] = '0' + (reversed % 10);
+
+    int first_digit = position;
+
+    do {
+        buffer[position] = '0' + (magnitude % 10);
         position++;
 
-        reversed /= 10;
-    }
+        magnitude /= 10;
+    } while(magnitude > 0);
 
     buffer[position] = '\0';
-    return;
+
+    // Digits were written from the least significant one
+    for(int i = first_digit, j = position - 1; i < j; i++, j--) {
+        char digit = buffer[i];
+
+        buffer[i] = buffer[j];
+        buffer[j] = digit;
+    }
 }
 
 void print_real(Real f) {
@@ -62,6 +56,28 @@ void print_real(Real f) {
     fputs(buffer, stdout);
 }
 
+size_t hash_string(const char *string) {
+    size_t hash = 5381;
+
+    for(const char *current = string; *current != '\0'; current++) {
+        hash = (hash * 33) + static_cast<unsigned char>(*current);
+    }
+
+    return hash;
+}
+
+size_t hash_bytes(const void *bytes, size_t length) {
+    const unsigned char *current = static_cast<const unsigned char *>(bytes);
+
+    size_t hash = 5381;
+
+    for(size_t i = 0; i < length; i++) {
+        hash = (hash * 33) + current[i];
+    }
+
+    return hash;
+}
+
 #ifdef TARGET_6502
 char *strdup(const char *input) {
     int input_length = strlen(input);
@@ -121,6 +137,12 @@ void get_real_string(Real f, char *buffer) {
         f = -f;
     }
 
+    // Too large to be taken apart as an Integral (as when converted from a bignum)
+    if(f >= static_cast<Real>(INTEGRAL_MAXIMUM)) {
+        snprintf(buffer + position, MAX_NUMERIC_STRING_LENGTH - position, "%e", f);
+        return;
+    }
+
     Integral integral_part = static_cast<Integral>(f);
     Integral fractional_part = ((f - (Real) integral_part) * 1000000);
 
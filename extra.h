@@ -1,6 +1,8 @@
 #ifndef EXTRA_H
 #define EXTRA_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 #ifdef TARGET_6502
@@ -15,6 +17,10 @@ void get_real_string(Real f, char *buffer);
 void print_integral(Integral n);
 void print_real(Real f);
 
+// Hashes for the symbol table and hash tables (djb2)
+size_t hash_string(const char *string);
+size_t hash_bytes(const void *bytes, size_t length);
+
 #define Allocate malloc
 #define Deallocate free
 
@@ -1,7 +1,7 @@
 #ifndef LAMBDAS_H
 #define LAMBDAS_H
 
-constexpr int NUMBER_INITIAL_LAMBDAS = 23;
+constexpr int NUMBER_INITIAL_LAMBDAS = 14;
 
 const char *lambda_names[] {
     "map",
@@ -15,15 +15,6 @@ const char *lambda_names[] {
     "flatten",
     "list?",
     "abs",
-    "modulo",
-    "list->string",
-    "string->list",
-    "string-ref",
-    "string-set!",
-    "make-string",
-    "string-length",
-    "string-append",
-    "substring",
     "pair",
     "assoc-replace",
     "assoc-delete"
@@ -85,67 +76,6 @@ const char *lambda_strings[] {
 ")",
 // abs
 "(lambda (x) (if (> x 0) x (neg x)))",
-// modulo
-"(lambda (x m) (- x (* (/ x m) m)))",
-// list->string
-"(lambda (lst)"
-"    (foldl (lambda (first acc) (string-append (make-string 1 first) acc)) \"\" (reverse lst))"
-")",
-// string->list
-"(lambda (str)"
-"    (cond"
-"        ((eq? str \"\") '())"
-"        (#t (cons (string-ref str 0) (string->list (substring str 1 (string-length str)))))"
-"    )"
-")",
-// "string-ref"
-"(lambda (str pos)"
-"    (mem-read (+ (mem-addr str) pos))"
-")",
-// "string-set!"
-"(lambda (str pos chr)"
-"    (mem-write (+ (mem-addr str) pos) chr)"
-")",
-// "make-string"
-"(lambda (size init)"
-"    (begin"
-"        (define result (mem-fill (mem-alloc (+ size 1)) init size))"
-"        (mem-write (+ (mem-addr result) size) 0)"
-"        (data->string result)"
-"    )"
-")",
-// "string-length"
-"(lambda (input)"
-"    (begin"
-"        (define (helper str cur)"
-"            (cond"
-"                ((eq? (mem-read (+ (mem-addr str) cur)) (integer->char 0)) 0)"
-"                (#t (+ 1 (helper str (+ cur 1))))"
-"            )"
-"        )"
-"        (helper input 0)"
-"    )"
-")",
-// "string-append"
-"(lambda (str1 str2)"
-"    (begin"
-"        (define len1 (string-length str1))"
-"        (define len2 (string-length str2))"
-"        (define result (make-string (+ len1 len2) 0))"
-"        (mem-copy (mem-addr result) (mem-addr str1) len1)"
-"        (mem-copy (+ (mem-addr result) len1) (mem-addr str2) len2)"
-"        result"
-"    )"
-")",
-// "substring"
-"(lambda (str start finish)"
-"    (begin"
-"        (define size (+ (- finish start) 1))"
-"        (define result (make-string size 0))"
-"        (mem-copy (mem-addr result) (+ (mem-addr str) start) size)"
-"        result"
-"    )"
-")",
 // pair
 "(lambda (a b) (cons a (cons b '())))",
 // assoc-replace
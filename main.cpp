@@ -3,6 +3,8 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <limits.h>
+#include <errno.h>
 
 #include "operators.h"
 #include "lambdas.h"
@@ -11,9 +13,29 @@
 #include "extra.h"
 
 #include "LispNode.h"
+#include "SymbolTable.h"
+#include "Bytecode.h"
+#include "SegmentedStack.hpp"
+
+#ifdef HASH_TABLES
+#include "HashMap.h"
+#endif /* HASH_TABLES */
+
+#ifdef MARK_AND_SWEEP
+#include "GarbageCollector.h"
+#endif /* MARK_AND_SWEEP */
+
+#ifdef CYCLE_COLLECTOR
+#include "CycleCollector.h"
+#endif /* CYCLE_COLLECTOR */
 
 constexpr unsigned int MAX_EXPRESSION_SIZE = 1024;
+// Long tokens are mostly strings and bignum literals
+#ifdef TARGET_6502
 constexpr unsigned int MAX_TOKEN_SIZE = 64;
+#else
+constexpr unsigned int MAX_TOKEN_SIZE = MAX_EXPRESSION_SIZE;
+#endif /* TARGET_6502 */
 
 constexpr int PARSE_CHARACTER = 0x1;
 constexpr int PARSE_QUOTED = 0x2;
@@ -26,7 +48,14 @@ LispNodeRC atom_true;
 LispNodeRC atom_false;
 LispNodeRC list_empty;
 
-// Global environment
+// Interned symbol that packs the remaining arguments in a parameter list
+LispNodeRC symbol_dot;
+
+// Separate copy of the lambda operator: its identity marks lambdas already resolved
+LispNodeRC operator_lambda_resolved;
+
+// Global environment (top-level bindings live in the value cell of each symbol,
+// so this is the empty local environment that top-level expressions start from)
 LispNodeRC global_environment;
 
 // Environment to modify upon defines (only changed upon begin statements)
@@ -66,10 +95,7 @@ int string_index(const char *query, const char **list, int maximum) {
 // Make operators
 
 LispNodeRC make_operator(int operation_index) {
-	LispNode *result = new LispNode(LispType::AtomOperator);
-	result->number_i = operation_index;
-
-	return result;
+	return LispNode::make_operator(operation_index);
 }
 
 LispNodeRC make1(const LispNodeRC &first) {
@@ -170,29 +196,132 @@ LispNodeRC make_query_optional_replace(const LispNodeRC &term, const LispNodeRC
 	return nullptr;
 }
 
-LispNodeRC make_substitution(const LispNodeRC &old_symbol, const LispNodeRC &new_symbol, const LispNodeRC &expression) {
-	if(expression->is_atom()) {
-		return (expression == old_symbol) ? new_symbol : expression;
+LispNodeRC lookup_symbol(const LispNodeRC &symbol, const LispNodeRC &environment) {
+	// Try to get an environment definition, then a global definition
+	LispNodeRC value = make_query_optional_replace(symbol, environment);
+
+	if(value == nullptr) {
+		value = symbol->symbol->value;
+	}
+
+	return value;
+}
+
+LispNodeRC make_copy(const LispNodeRC &expression) {
+	if(expression->is_atom() || expression->head == nullptr) {
+		return expression;
 	}
 
 	LispNode *output = new LispNode(LispType::List);
 
 	Box *last_box = nullptr;
 
-	for(Box *current_expression_box = expression->get_head_pointer(); current_expression_box != nullptr; current_expression_box = current_expression_box->get_next_pointer()) {
-		Box *substituted_box = new Box(make_substitution(old_symbol, new_symbol, current_expression_box->item)); 
+	for(Box *current_box = expression->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		Box *copied_box = new Box(make_copy(current_box->item));
+
+		if(last_box == nullptr) {
+			output->head = copied_box;
+		}
+		else {
+			last_box->next = copied_box;
+		}
+
+		last_box = copied_box;
+	}
+
+	return output;
+}
+
+// Copies code that may have been resolved in place (see resolve_lambda()) back into the form
+// the reader produced, so that macros see the same arguments whether they were defined before
+// or after their callers: locals become symbols again and resolved lambdas lose their code
+LispNodeRC make_unresolved(const LispNodeRC &expression) {
+	if(expression->is_local()) {
+		return expression->local->symbol;
+	}
+
+	if(expression->is_atom() || expression->head == nullptr) {
+		return expression;
+	}
+
+	LispNode *output = new LispNode(LispType::List);
+
+	Box *last_box = nullptr;
+
+	for(Box *current_box = expression->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+#ifdef BYTECODE
+		if(current_box->item->is_code()) {
+			continue;
+		}
+#endif /* BYTECODE */
+
+		Box *copied_box = new Box(current_box->item.get_pointer() == operator_lambda_resolved.get_pointer() ? make_operator(OP_LAMBDA) : make_unresolved(current_box->item));
 
 		if(last_box == nullptr) {
-			output->head = substituted_box;
+			output->head = copied_box;
 		}
 		else {
-			last_box->next = substituted_box;
+			last_box->next = copied_box;
+		}
+
+		last_box = copied_box;
+	}
+
+	return output;
+}
+
+// Replaces, in a single traversal, each atom that is a key of substitutions (a list of
+// (old new) pairs, as in an environment) by its value. If share is set, a list without
+// replacements is returned as it is, and a changed list keeps its unchanged tail;
+// otherwise, the result is a fresh copy (values included) that can be changed in place
+LispNodeRC make_substitution(const LispNodeRC &substitutions, const LispNodeRC &expression, bool share = true) {
+	if(expression->is_atom()) {
+		LispNodeRC replacement = make_query_optional_replace(expression, substitutions);
+
+		if(replacement == nullptr) {
+			return expression;
+		}
+
+		return share ? replacement : make_copy(replacement);
+	}
+
+	LispNode *output = nullptr;
+
+	Box *last_box = nullptr;
+	Box *uncopied_box = expression->get_head_pointer();
+
+	for(Box *current_expression_box = expression->get_head_pointer(); current_expression_box != nullptr; current_expression_box = current_expression_box->get_next_pointer()) {
+		LispNodeRC substituted = make_substitution(substitutions, current_expression_box->item, share);
+
+		if(share && substituted.get_pointer() == current_expression_box->item.get_pointer()) {
+			continue;
+		}
+
+		if(output == nullptr) {
+			output = new LispNode(LispType::List);
+		}
+
+		// Copies the boxes skipped so far, then the substituted one
+		for(; uncopied_box != current_expression_box->get_next_pointer(); uncopied_box = uncopied_box->get_next_pointer()) {
+			Box *substituted_box = new Box(uncopied_box == current_expression_box ? substituted : uncopied_box->item);
+
+			if(last_box == nullptr) {
+				output->head = substituted_box;
+			}
+			else {
+				last_box->next = substituted_box;
+			}
+
+			last_box = substituted_box;
 		}
+	}
 
-		last_box = substituted_box;
+	if(output == nullptr) {
+		return expression;
 	}
 
-	// The last output is the result of the expression
+	last_box->next = uncopied_box;
+
 	return output;
 }
 
@@ -284,13 +413,17 @@ char *get_next_token(const char *buffer, size_t buffer_length, size_t &position)
 	// - Case 1: quoted strings
 	// - Case 2: everything else
 
-	int result_position = 0;
+	unsigned int result_position = 0;
 
 	if(current == '"') {
 		// Case 1: quoted strings
 
 		do {
-			// Collect any character before the end quote
+			// Collect any character before the end quote (leaving room for it and the terminator)
+			if(result_position + 2 >= MAX_TOKEN_SIZE) {
+				return nullptr;
+			}
+
 			result[result_position] = current;
 			result_position++;
 
@@ -313,6 +446,10 @@ char *get_next_token(const char *buffer, size_t buffer_length, size_t &position)
 
 		do {
 			// Collect the non-space, non-parenthesis, non-quote character
+			if(result_position + 1 >= MAX_TOKEN_SIZE) {
+				return nullptr;
+			}
+
 			result[result_position] = current;
 			result_position++;
 
@@ -385,13 +522,8 @@ LispNodeRC parse_atom(char *token) {
 		return atom_false;	
 	}
 
-	LispNode *result = new LispNode(LispType::AtomPure);
-
 	if(output & PARSE_CHARACTER) {
-		result->type = LispType::AtomCharacter;
-		result->number_i = token[2];
-
-		return result;
+		return LispNode::make_character(token[2]);
 	}
 
 	if(output & PARSE_QUOTED) {
@@ -399,24 +531,40 @@ LispNodeRC parse_atom(char *token) {
 		token[strlen(token) - 1] = '\0';
 		token++;
 
-		result->type = LispType::AtomString;
-		result->data = strdup(token);
-
-		return result;
+		return LispNode::make_string(token);
 	}
 
 	if(!(output & PARSE_ALPHA) && (output & PARSE_DIGIT) && (output & PARSE_DOT)) {
-		result->type = LispType::AtomNumericReal;
+		LispNode *result = new LispNode(LispType::AtomNumericReal);
 		result->number_r = atof(token);
 
 		return result;
 	}
 
 	if(!(output & PARSE_ALPHA) && (output & PARSE_DIGIT) && !(output & PARSE_DOT)) {
-		result->type = LispType::AtomNumericIntegral;
-		result->number_i = atol(token);
+#ifdef BIGNUMS
+		// Too many digits to be sure they fit an Integral: read as a bignum (kept only if they do not)
+		if(strlen(token) > INTEGRAL_DIGITS) {
+			Bignum *bignum = Bignum::parse(token);
 
-		return result;
+			if(bignum != nullptr) {
+				return LispNode::make_bignum(bignum);
+			}
+		}
+#endif /* BIGNUMS */
+
+		errno = 0;
+
+		long value = strtol(token, nullptr, 10);
+
+		// strtol() saturates (only possible without bignums), which would silently change the number
+		if(errno == ERANGE || value < INTEGRAL_MINIMUM || value > INTEGRAL_MAXIMUM) {
+			print_error(token, "integer out of range\n");
+
+			return nullptr;
+		}
+
+		return LispNode::make_integer(value);
 	}
 
 	// Operator or pure atoms
@@ -424,16 +572,11 @@ LispNodeRC parse_atom(char *token) {
 	int operation_index = get_operation_index(token);
 
 	if(operation_index != -1) {
-		result->type = LispType::AtomOperator;
-		result->number_i = operation_index;
-	}
-	else {
-		result->type = LispType::AtomPure;
-		result->data = strdup(token);
+		return make_operator(operation_index);
 	}
 
-	// Converted to LispNodeRC
-	return result;
+	// Pure atoms are interned: every occurrence of a name shares the same node
+	return LispNode::make_symbol(token);
 }
 
 LispNodeRC parse_expression(const char *buffer, size_t buffer_length, size_t &position, bool &error) {
@@ -492,7 +635,13 @@ LispNodeRC parse_expression(const char *buffer, size_t buffer_length, size_t &po
 		return nullptr;
 	}
 
-	return parse_atom(token);
+	LispNodeRC atom = parse_atom(token);
+
+	if(atom == nullptr) {
+		error = true;
+	}
+
+	return atom;
 }
 
 LispNodeRC parse_expression(const char *buffer, bool deallocate_buffer = true) {
@@ -530,11 +679,7 @@ unsigned int count_members(const LispNodeRC &list) {
 
 // Eval functions
 
-LispNodeRC eval_gen0(const LispNodeRC &input, const LispNodeRC &environment) {
-	const LispNodeRC &operator_name = input->head->item;
-
-	int operation_index = operator_name->number_i;
-
+LispNodeRC eval_gen0(int operation_index, const LispNodeRC &environment) {
 	switch(operation_index) {
 		case OP_READ: {
 			char *input_string = read_expression();
@@ -552,16 +697,16 @@ LispNodeRC eval_gen0(const LispNodeRC &input, const LispNodeRC &environment) {
 		}
 		case OP_CURRENT_ENVIRONMENT:
 			return environment;
+#ifdef HASH_TABLES
+		case OP_MAKE_HASH_TABLE:
+			return LispNode::make_hash_map();
+#endif /* HASH_TABLES */
 	}
 
 	return nullptr;
 }
 
-LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
-	LispNodeRC &operator_name = input->head->item;
-	LispNodeRC &output1 = input->head->next->item;
-
-	int operation_index = operator_name->number_i;
+LispNodeRC eval_gen1(int operation_index, LispNodeRC &output1, const LispNodeRC &environment) {
 	LispNode *result = nullptr;
 
 	switch(operation_index) {
@@ -584,16 +729,15 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 		case OP_NUMBER_Q:
 			return output1->is_numeric() ? atom_true : atom_false;
 		case OP_INTEGER_Q:
-			return output1->is_numeric_integral() ? atom_true : atom_false;
+			return (output1->is_numeric_integral() || output1->is_numeric_big()) ? atom_true : atom_false;
 		case OP_REAL_Q:
 			return output1->is_numeric_real() ? atom_true : atom_false;
 		case OP_INTEGER_REAL:
-			if(!output1->is_numeric_integral()) {
+			if(!output1->is_numeric_integral() && !output1->is_numeric_big()) {
 				return nullptr;
 			}
 
-			result = new LispNode(LispType::AtomNumericReal);
-			result->number_r = output1->number_i;
+			result = LispNode::make_real(output1->get_real());
 
 			break;
 		case OP_REAL_INTEGER:
@@ -601,11 +745,10 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 				return nullptr;
 			}
 
-			result = new LispNode(LispType::AtomNumericIntegral);
 #ifdef TARGET_6502
-			result->number_i = output1->number_r.as_i();
+			result = LispNode::make_integer(output1->number_r.as_i());
 #else
-			result->number_i = output1->number_r;
+			result = LispNode::make_integer(output1->number_r);
 #endif /* TARGET_6502 */
 
 			break;
@@ -620,8 +763,7 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 				return nullptr;
 			}
 
-			result = new LispNode(LispType::AtomCharacter);
-			result->number_i = output1->number_i;
+			result = LispNode::make_character(output1->number_i);
 
 			break;
     	case OP_CHAR_INTEGER:
@@ -629,8 +771,7 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 				return nullptr;
 			}
 
-			result = new LispNode(LispType::AtomNumericIntegral);
-			result->number_i = output1->number_i;
+			result = LispNode::make_integer(output1->number_i);
 
 			break;
     	case OP_NUMBER_STRING: {
@@ -638,6 +779,18 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 				return nullptr;
 			}
 
+#ifdef BIGNUMS
+			if(output1->is_numeric_big()) {
+				char *digits = output1->bignum->get_string();
+
+				result = LispNode::make_string(digits);
+
+				Deallocate(digits);
+
+				break;
+			}
+#endif /* BIGNUMS */
+
 			char *string_buffer = static_cast<char *>(Allocate(MAX_NUMERIC_STRING_LENGTH));
 
 			if(output1->is_numeric_integral()) {
@@ -647,131 +800,262 @@ LispNodeRC eval_gen1(const LispNodeRC &input, const LispNodeRC &environment) {
 				get_real_string(output1->number_r, string_buffer);
 			}
 
-			result = new LispNode(LispType::AtomString);
-			result->data = strdup(string_buffer);
+			result = LispNode::make_string(string_buffer);
 
 			Deallocate(string_buffer);
 
 			break;
 		}
-    	case OP_STRING_NUMBER:
+    	case OP_STRING_NUMBER: {
 			if(!output1->is_string()) {
 				return nullptr;
 			}
 
-			result = parse_atom(output1->data).get_pointer();
+			// Parsing can change the token, so it works on a copy
+			char *token = strdup(output1->get_string());
 
-			if(result == nullptr || !result->is_numeric()) {
+			// Kept referenced until returned (a bare pointer would be released with the temporary)
+			LispNodeRC number = parse_atom(token);
+
+			free(token);
+
+			if(number == nullptr || !number->is_numeric()) {
 				return nullptr;
 			}
 
-			break;
-		case OP_STRING_DATA: {
+			return number;
+		}
+		case OP_STRING_DATA:
 			if(!output1->is_string()) {
 				return nullptr;
 			}
 
-			// Note: we do not duplicate data, only convert it in place
-			output1->type = LispType::AtomData;
-			return output1;
-		}
-		case OP_DATA_STRING: {
+			// Strings keep their length before the characters (or inside the node), so the data is a copy
+			result = LispNode::make_data(LispType::AtomData, strdup(output1->get_string()));
+
+			break;
+		case OP_DATA_STRING:
 			if(!output1->is_data()) {
 				return nullptr;
 			}
 
-			// Note: we do not duplicate data, only convert it in place
-			output1->type = LispType::AtomString;
-			return output1;
-		}
-    	case OP_DISPLAY:
-    	case OP_WRITE:
-			output1->print();
-
-			return list_empty;
-		case OP_MEM_ALLOC:
-			result = new LispNode(LispType::AtomData);
-			result->data = static_cast<char *>(malloc(output1->number_i));
+			result = LispNode::make_string(output1->data);
 
 			break;
-		case OP_MEM_READ:
-			result = new LispNode(LispType::AtomCharacter);
-			result->number_i = static_cast<Integral>(*((volatile char *) output1->number_i));
+		case OP_STRING_LENGTH:
+			if(!output1->is_string()) {
+				return nullptr;
+			}
 
-			break;
-		case OP_MEM_ADDR:
-			result = new LispNode(LispType::AtomNumericIntegral);
-			result->number_i = static_cast<Integral>((size_t) output1->data);
+			result = LispNode::make_integer(output1->get_string_length());
 
 			break;
-	}
+		case OP_LIST_STRING: {
+			if(!output1->is_list()) {
+				return nullptr;
+			}
 
-	return result;
-}
+			// Checked before allocating, so the string is built in a single buffer
+			for(Box *current_box = output1->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+				if(!current_box->item->is_character() || current_box->item->number_i == 0) {
+					return nullptr;
+				}
+			}
 
-LispNodeRC eval_gen2(const LispNodeRC &input, const LispNodeRC &environment) {
-	LispNodeRC &operator_name = input->head->item;
-	LispNodeRC &output1 = input->head->next->item;
-	LispNodeRC &output2 = input->head->next->next->item;
+			result = LispNode::make_string(count_members(output1));
 
-	int operation_index = operator_name->number_i;
-	LispNode *result = nullptr;
+			char *current = result->get_string();
 
-	if(operation_index >= OP_PLUS && operation_index <= OP_BIGGER_EQUAL) {
-		if(!output1->is_numeric() || !output2->is_numeric()) {
-			return nullptr;
+			for(Box *current_box = output1->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+				*current++ = static_cast<char>(current_box->item->number_i);
+			}
+
+			break;
 		}
+		case OP_STRING_LIST: {
+			if(!output1->is_string()) {
+				return nullptr;
+			}
+
+			size_t length = output1->get_string_length();
+
+			if(length == 0) {
+				return list_empty;
+			}
+
+			BoxRC character_sequence = nullptr;
 
-		bool promote1 = false;
-		bool promote2 = false;
+			for(size_t i = length; i > 0; i--) {
+				character_sequence = new Box(LispNode::make_character(static_cast<unsigned char>(output1->get_string()[i - 1])), character_sequence);
+			}
+
+			result = LispNode::make_list(character_sequence.get_pointer());
 
-		if(output1->is_numeric_real() && !output2->is_numeric_real()) {
-			output2->promoteReal();
-			promote2 = true;
+			break;
 		}
+#ifdef VECTORS
+		case OP_VECTOR_Q:
+			return output1->is_vector() ? atom_true : atom_false;
+		case OP_VECTOR_LENGTH:
+			if(!output1->is_vector()) {
+				return nullptr;
+			}
+
+			result = LispNode::make_integer(output1->vector->length);
+
+			break;
+		case OP_VECTOR_LIST: {
+			if(!output1->is_vector()) {
+				return nullptr;
+			}
+
+			if(output1->vector->length == 0) {
+				return list_empty;
+			}
+
+			BoxRC item_sequence = nullptr;
+
+			for(unsigned int i = output1->vector->length; i > 0; i--) {
+				item_sequence = new Box(output1->vector->items[i - 1], item_sequence);
+			}
+
+			result = LispNode::make_list(item_sequence.get_pointer());
 
-		if(!output1->is_numeric_real() && output2->is_numeric_real()) {
-			output1->promoteReal();
-			promote1 = true;
+			break;
 		}
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case OP_HASH_TABLE_Q:
+			return output1->is_hash_map() ? atom_true : atom_false;
+		case OP_HASH_TABLE_COUNT:
+			if(!output1->is_hash_map()) {
+				return nullptr;
+			}
 
-		if (operation_index >= OP_PLUS && operation_index <= OP_DIVIDE) {
-			if(operation_index == OP_DIVIDE) {
-				if((output2->is_numeric_integral() && output2->number_i == 0) || (output2->is_numeric_real() && output2->number_r == Real(0.0))) {
-					return nullptr;
+			result = LispNode::make_integer(output1->hash_map->count);
+
+			break;
+		case OP_HASH_TABLE_KEYS:
+		case OP_HASH_TABLE_ALIST: {
+			if(!output1->is_hash_map()) {
+				return nullptr;
+			}
+
+			HashMap *hash_map = output1->hash_map;
+
+			if(hash_map->count == 0) {
+				return list_empty;
+			}
+
+			BoxRC entry_sequence = nullptr;
+
+			for(unsigned int i = 0; i < hash_map->capacity; i++) {
+				if(hash_map->keys[i] != nullptr) {
+					// Handing out the stored key would let string-set! change it behind the table
+					LispNodeRC key = HashMap::copy_key(hash_map->keys[i]);
+
+					entry_sequence = new Box(operation_index == OP_HASH_TABLE_KEYS ? key : make2(key, hash_map->values[i]), entry_sequence);
 				}
 			}
 
-			result = new LispNode(output1->type);
+			result = LispNode::make_list(entry_sequence.get_pointer());
+
+			break;
+		}
+#endif /* HASH_TABLES */
+#ifdef VECTORS
+		case OP_LIST_VECTOR: {
+			if(!output1->is_list()) {
+				return nullptr;
+			}
 
-			result->op_arithmetic(operation_index, output1, output2);
+			result = LispNode::make_vector(count_members(output1), list_empty);
 
-			if(promote1) {
-				output1->demoteReal();
+			if(result == nullptr) {
+				return nullptr;
 			}
 
-			if(promote2) {
-				output2->demoteReal();
+			unsigned int i = 0;
+
+			for(Box *current_box = output1->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+				result->vector->items[i++] = current_box->item;
 			}
 
-			return result;
+			break;
 		}
+#endif /* VECTORS */
+		case OP_BITWISE_NOT:
+			if(output1->is_numeric_integral()) {
+				return LispNode::make_integer(~output1->number_i);
+			}
+
+#ifdef BIGNUMS
+			if(output1->is_numeric_big()) {
+				// As in two's complement, ~x is -1 - x
+				return LispNode::make_bignum(Bignum::subtract(Bignum(Integral(-1)), *output1->bignum));
+			}
+#endif /* BIGNUMS */
+
+			return nullptr;
+		case OP_BIT_COUNT: {
+			// Negative values count the bits set in their complement
+			if(output1->is_numeric_integral()) {
+				UnsignedIntegral bits = static_cast<UnsignedIntegral>(output1->number_i < 0 ? ~output1->number_i : output1->number_i);
+				Integral count = 0;
+
+				for(; bits != 0; bits &= (bits - 1)) {
+					count++;
+				}
 
-		if(operation_index >= OP_LESS && operation_index <= OP_BIGGER_EQUAL) {
-			bool comparison_result = output1->op_comparison(operation_index, output2);
+				return LispNode::make_integer(count);
+			}
 
-			if(promote1) {
-				output1->demoteReal();
+#ifndef BIGNUMS
+			return nullptr;
+#else
+			if(!output1->is_numeric_big()) {
+				return nullptr;
 			}
 
-			if(promote2) {
-				output2->demoteReal();
+			if(output1->bignum->negative) {
+				Bignum *complement = Bignum::subtract(Bignum(Integral(-1)), *output1->bignum);
+
+				result = LispNode::make_integer(complement->get_bit_count());
+
+				delete complement;
+
+				break;
 			}
 
-			return (comparison_result ? atom_true : atom_false);
+			return LispNode::make_integer(output1->bignum->get_bit_count());
+#endif /* BIGNUMS */
 		}
+    	case OP_DISPLAY:
+    	case OP_WRITE:
+			output1->print();
+
+			return list_empty;
+		case OP_MEM_ALLOC:
+			result = new LispNode(LispType::AtomData);
+			result->data = static_cast<char *>(malloc(output1->number_i));
+
+			break;
+		case OP_MEM_READ:
+			result = LispNode::make_character(static_cast<Integral>(*((volatile char *) output1->number_i)));
+
+			break;
+		case OP_MEM_ADDR:
+			result = LispNode::make_integer(static_cast<Integral>((size_t) (output1->is_string() ? output1->get_string() : output1->data)));
+
+			break;
 	}
 
+	return result;
+}
+
+LispNodeRC eval_gen2(int operation_index, LispNodeRC &output1, LispNodeRC &output2, const LispNodeRC &environment) {
+	LispNode *result = nullptr;
+
 	switch(operation_index) {
 		case OP_CONS:
 			return make_cons(output1, output2);
@@ -791,41 +1075,239 @@ LispNodeRC eval_gen2(const LispNodeRC &input, const LispNodeRC &environment) {
 
 			return atom_true;
 		}
-	}
+		case OP_STRING_REF:
+			if(!output1->is_string() || !output2->is_numeric_integral() || output2->number_i < 0 || (size_t) output2->number_i >= output1->get_string_length()) {
+				return nullptr;
+			}
 
-	return result;
-}
+			result = LispNode::make_character(static_cast<unsigned char>(output1->get_string()[output2->number_i]));
 
-LispNodeRC eval_gen3(const LispNodeRC &input, const LispNodeRC &environment) {
-	LispNodeRC &operator_name = input->head->item;
-	LispNodeRC &output1 = input->head->next->item;
-	LispNodeRC &output2 = input->head->next->next->item;
-	LispNodeRC &output3 = input->head->next->next->next->item;
-	
-	int operation_index = operator_name->number_i;
-	LispNode *result = nullptr;
+			break;
+		case OP_STRING_APPEND: {
+			if(!output1->is_string() || !output2->is_string()) {
+				return nullptr;
+			}
 
-	switch(operation_index) {
-		case OP_SUBST:
-			return make_substitution(output1, output2, output3);
-		case OP_MEM_FILL: {
-			memset((void *) output1->data, (char) output2->number_i, (size_t) output3->number_i);
-			return output1;
-		}
-		case OP_MEM_COPY: {
-			memcpy((void *) output1->data, (void *) output2->data, (size_t) output3->number_i);
-			return output1;
-		}
-	}
+			size_t length1 = output1->get_string_length();
+			size_t length2 = output2->get_string_length();
 
-	return result;
-}
+			result = LispNode::make_string(length1 + length2);
 
-const LispNodeRC &eval_procedure(const LispNodeRC &input, const LispNodeRC &environment) {
-	if(count_members(input) < 3) {
-		print_error("lambda", "missing arguments\n");
+			memcpy(result->get_string(), output1->get_string(), length1);
+			memcpy(result->get_string() + length1, output2->get_string(), length2);
 
-		return list_empty;
+			break;
+		}
+		case OP_MAKE_STRING: {
+			if(!output1->is_numeric_integral() || output1->number_i < 0 || !output2->is_character() || output2->number_i == 0) {
+				return nullptr;
+			}
+
+			result = LispNode::make_string(output1->number_i);
+
+			memset(result->get_string(), static_cast<char>(output2->number_i), output1->number_i);
+
+			break;
+		}
+		case OP_STRING_EQUAL_Q:
+		case OP_STRING_LESS_Q: {
+			if(!output1->is_string() || !output2->is_string()) {
+				return nullptr;
+			}
+
+			int comparison = strcmp(output1->get_string(), output2->get_string());
+
+			return (operation_index == OP_STRING_EQUAL_Q ? comparison == 0 : comparison < 0) ? atom_true : atom_false;
+		}
+		case OP_STRING_INDEX: {
+			if(!output1->is_string() || !output2->is_character()) {
+				return nullptr;
+			}
+
+			// The terminator is not part of the string
+			const char *position = static_cast<const char *>(memchr(output1->get_string(), static_cast<char>(output2->number_i), output1->get_string_length()));
+
+			if(position == nullptr) {
+				return atom_false;
+			}
+
+			result = LispNode::make_integer(position - output1->get_string());
+
+			break;
+		}
+#ifdef VECTORS
+		case OP_MAKE_VECTOR:
+			// Lengths are unsigned int (larger ones would be truncated)
+			if(!output1->is_numeric_integral() || output1->number_i < 0 || static_cast<uintmax_t>(output1->number_i) > UINT_MAX) {
+				return nullptr;
+			}
+
+			result = LispNode::make_vector(static_cast<unsigned int>(output1->number_i), output2);
+
+			break;
+		case OP_VECTOR_REF:
+			if(!output1->is_vector() || !output2->is_numeric_integral() || output2->number_i < 0 || output2->number_i >= output1->vector->length) {
+				return nullptr;
+			}
+
+			return output1->vector->items[output2->number_i];
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case OP_HASH_TABLE_REF:
+		case OP_HASH_TABLE_CONTAINS_Q: {
+			if(!output1->is_hash_map() || !HashMap::is_valid_key(output2)) {
+				return nullptr;
+			}
+
+			LispNodeRC value = output1->hash_map->get(output2);
+
+			if(operation_index == OP_HASH_TABLE_CONTAINS_Q) {
+				return (value != nullptr) ? atom_true : atom_false;
+			}
+
+			return value;
+		}
+		case OP_HASH_TABLE_DELETE_E:
+			if(!output1->is_hash_map() || !HashMap::is_valid_key(output2)) {
+				return nullptr;
+			}
+
+			return output1->hash_map->remove(output2) ? atom_true : atom_false;
+#endif /* HASH_TABLES */
+		case OP_QUOTIENT:
+		case OP_REMAINDER:
+		case OP_MODULO:
+		case OP_BITWISE_AND:
+		case OP_BITWISE_OR:
+		case OP_BITWISE_XOR:
+		case OP_ARITHMETIC_SHIFT: {
+			if(!(output1->is_numeric_integral() || output1->is_numeric_big()) || !(output2->is_numeric_integral() || output2->is_numeric_big())) {
+				return nullptr;
+			}
+
+			// Bignums are never zero (zero is always a plain integer)
+			if(operation_index <= OP_MODULO && output2->is_numeric_integral() && output2->number_i == 0) {
+				return nullptr;
+			}
+
+			if(output1->is_numeric_integral() && output2->is_numeric_integral()) {
+				Integral value;
+
+				if(LispNode::op_arithmetic_integer(operation_index, output1->number_i, output2->number_i, value)) {
+					return LispNode::make_integer(value);
+				}
+			}
+
+#ifdef BIGNUMS
+			// A bignum argument, or an integer operation that overflowed
+			Bignum *value = LispNode::op_arithmetic_big(operation_index, output1->get_bignum(), output2->get_bignum());
+
+			if(value == nullptr) {
+				return nullptr;
+			}
+
+			return LispNode::make_bignum(value);
+#else
+			// Overflows are errors without bignums
+			return nullptr;
+#endif /* BIGNUMS */
+		}
+	}
+
+	return result;
+}
+
+LispNodeRC eval_gen3(int operation_index, LispNodeRC &output1, LispNodeRC &output2, LispNodeRC &output3, const LispNodeRC &environment) {
+	LispNode *result = nullptr;
+
+	switch(operation_index) {
+		case OP_SUBST:
+			return make_substitution(make1(make2(output1, output2)), output3);
+		case OP_MEM_FILL: {
+			memset((void *) output1->data, (char) output2->number_i, (size_t) output3->number_i);
+			return output1;
+		}
+		case OP_MEM_COPY: {
+			memcpy((void *) output1->data, (void *) output2->data, (size_t) output3->number_i);
+			return output1;
+		}
+		case OP_STRING_SET_E:
+			if(!output1->is_string() || !output2->is_numeric_integral() || output2->number_i < 0 || (size_t) output2->number_i >= output1->get_string_length() || !output3->is_character() || output3->number_i == 0) {
+				return nullptr;
+			}
+
+			output1->get_string()[output2->number_i] = static_cast<char>(output3->number_i);
+
+			return list_empty;
+		case OP_SUBSTRING: {
+			if(!output1->is_string() || !output2->is_numeric_integral() || !output3->is_numeric_integral()) {
+				return nullptr;
+			}
+
+			// The end is exclusive, as in R7RS
+			if(output2->number_i < 0 || output3->number_i < output2->number_i || (size_t) output3->number_i > output1->get_string_length()) {
+				return nullptr;
+			}
+
+			size_t length = output3->number_i - output2->number_i;
+
+			result = LispNode::make_string(length);
+
+			memcpy(result->get_string(), output1->get_string() + output2->number_i, length);
+
+			break;
+		}
+#ifdef VECTORS
+		case OP_VECTOR_SET_E:
+			if(!output1->is_vector() || !output2->is_numeric_integral() || output2->number_i < 0 || output2->number_i >= output1->vector->length) {
+				return nullptr;
+			}
+
+			output1->vector->items[output2->number_i] = output3;
+
+			return list_empty;
+#endif /* VECTORS */
+#ifdef HASH_TABLES
+		case OP_HASH_TABLE_REF_DEFAULT: {
+			if(!output1->is_hash_map() || !HashMap::is_valid_key(output2)) {
+				return nullptr;
+			}
+
+			LispNodeRC value = output1->hash_map->get(output2);
+
+			return (value != nullptr) ? value : output3;
+		}
+		case OP_HASH_TABLE_SET_E:
+			if(!output1->is_hash_map() || !HashMap::is_valid_key(output2)) {
+				return nullptr;
+			}
+
+			output1->hash_map->set(output2, output3);
+
+			return list_empty;
+#endif /* HASH_TABLES */
+	}
+
+	return result;
+}
+
+// Operators that take their arguments evaluated, and that vm_call_operator() reduces
+// (apply and eval also take any number of evaluated arguments, but the VM runs them itself)
+inline bool is_native_procedure(int operation_index) {
+	ReduceMode reduce_mode = operator_reduce_modes[operation_index];
+
+	if(reduce_mode == NormalX) {
+		return (operation_index != OP_APPLY && operation_index != OP_EVAL);
+	}
+
+	return (reduce_mode >= Normal0 && reduce_mode <= Normal3);
+}
+
+const LispNodeRC &eval_procedure(const LispNodeRC &input, const LispNodeRC &environment) {
+	if(count_members(input) < 3) {
+		print_error("lambda", "missing arguments\n");
+
+		return list_empty;
 	}
 
 	const LispNodeRC &argument1 = input->head->next->item;
@@ -855,961 +1337,2908 @@ const LispNodeRC &eval_macro(const LispNodeRC &input, const LispNodeRC &environm
 	return eval_procedure(input, environment);
 }
 
-LispNodeRC eval_lambda(const LispNodeRC &input, const LispNodeRC &environment) {
-	if(eval_procedure(input, environment) == list_empty) {
-		return nullptr;
+// Bindings of let, let* and letrec: a list of (<name> <value>) pairs
+bool has_valid_bindings(const LispNodeRC &bindings) {
+	if(!bindings->is_list()) {
+		return false;
 	}
 
-	return make4(make_operator(OP_CLOSURE), list_empty, input, environment);
-}
-
-#ifndef SEPARATE_FRAMES
-inline const LispNodeRC &make_environment(const LispNodeRC &environment) {
-	return environment;
-}
-#else
-LispNodeRC make_environment(const LispNodeRC &environment) {
-	// Creates an environment with a dummy entry to separate frames
-	LispNodeRC new_environment = make_cons(make2(atom_false, atom_false), environment);
+	for(Box *current_binding_box = bindings->get_head_pointer(); current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+		const LispNodeRC &binding = current_binding_box->item;
 
-	return new_environment;
-}
-#endif /* SEPARATE_FRAMES */
+		if(!binding->is_list() || count_members(binding) != 2) {
+			return false;
+		}
 
-LispNodeRC make_lambda_macro_application(const LispNodeRC &input, const LispNodeRC &environment) {
-	const LispNodeRC &closure_or_macro = input->head->item;
+		if(!binding->head->item->is_atom() || !binding->head->item->is_pure()) {
+			return false;
+		}
+	}
 
-	int operator_index = closure_or_macro->head->item->number_i;
+	return true;
+}
 
-	// Defines if we operate on macro substitution mode or in closure application mode
-	bool is_closure = (operator_index == OP_CLOSURE);
-	bool is_macro = (operator_index == OP_MACRO);
+// Lexical addressing
+//
+// The environment of a closure body is its parameters (last one first) consed onto the
+// environment captured by the closure, so frames are flattened in one list and a
+// (frame depth, slot) address becomes a single offset. For each local variable referenced
+// in the body, the resolver rewrites the reference as a local atom holding that offset,
+// which is evaluated by skipping <offset> bindings without comparing any of them.
+// The forms let, let* and letrec cons their bindings the same way, extending the scope
+// of their body (and of the inits, for let* and letrec).
+//
+// Bodies that define names (with define) change their environment at runtime
+// and are not resolved. If a resolved offset does not hold the expected symbol at
+// runtime (e.g. a macro introduced bindings), the lookup falls back to the name.
+
+int scope_offset(const LispNodeRC &symbol, const LispNodeRC &scope) {
+	int offset = 0;
+
+	for(Box *current_box = scope->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(current_box->item.get_pointer() == symbol.get_pointer()) {
+			return offset;
+		}
 
-	const LispNodeRC &procedure = (is_closure ? closure_or_macro->head->next->next->item : closure_or_macro);
-	const LispNodeRC &procedure_parameters = procedure->head->next->item;
+		offset++;
+	}
 
-	// Evaluate the function by setting a new environment for the defined parameters
+	return -1;
+}
 
-	// Used when is_macro == #t:
-	//     Macro expansion: substitutes non-evaluated parameters into arguments in the original expression
-	LispNodeRC new_expression = LispNode::make_list(procedure->get_head_pointer()->get_next_pointer()->get_next_pointer());
-	// Used when is_macro == #f:
-	//     Eager evaluation: creates a new environment binding parameters to their eagerly-evaluated arguments
-	LispNodeRC new_environment = (is_closure ? make_environment(closure_or_macro->head->next->next->next->item) : environment);
+bool has_local_definitions(const LispNodeRC &expression) {
+	if(expression->is_atom() || expression->head == nullptr) {
+		return false;
+	}
 
-	if(is_closure) {
-		const LispNodeRC &closure_name = closure_or_macro->head->next->item;
+	const LispNodeRC &first = expression->head->item;
 
-		if(closure_name != list_empty && make_query_optional_replace(closure_name, new_environment) == nullptr) {
-			new_environment = make_cons(make2(closure_name, closure_or_macro), new_environment);
+	if(first->is_operator()) {
+		switch(first->number_i) {
+			case OP_DEFINE:
+				return true;
+			case OP_QUOTE:
+			case OP_LAMBDA:
+			case OP_MACRO:
+				// Nested lambdas get their own (separately resolved) environment
+				return false;
 		}
 	}
 
-	bool packed_dot = false;
+	for(Box *current_box = expression->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(has_local_definitions(current_box->item)) {
+			return true;
+		}
+	}
 
-	Box *current_parameter_box = procedure_parameters->get_head_pointer();
-	Box *current_argument_box = input->get_head_pointer()->get_next_pointer();
+	return false;
+}
 
-	while(current_parameter_box != nullptr || current_argument_box != nullptr) {
-		if(current_parameter_box == nullptr || current_argument_box == nullptr) {
-			print_error("operator application", "missing or extra arguments\n");
+// Macro expansion
+//
+// Before a lambda body is resolved, each call to a global macro in it is replaced by the macro
+// body with the arguments substituted, as make_lambda_macro_application() does when the call is
+// evaluated, so running the body never substitutes again. Calls are still applied at runtime
+// when the macro is defined after the lambda was first evaluated, when the number of arguments
+// is wrong (so the error is reported then), or when expansions nest too deep (recursive macros).
 
-			return nullptr;
-		}
+constexpr unsigned int MAXIMUM_EXPANSION_DEPTH = 8;
 
-		// Evaluate the argument using the old environment
-		LispNodeRC parameter = current_parameter_box->item;
-		LispNodeRC argument = current_argument_box->item;
+LispNodeRC make_lambda_macro_application(const LispNodeRC &input, const LispNodeRC &environment);
 
-		if(strcmp(parameter->data, ".") == 0) {
-			// Get the name of the other parameters and bind them into a list
-			current_parameter_box = current_parameter_box->get_next_pointer();
-			parameter = current_parameter_box->item;
-			
-			argument = LispNode::make_list(current_argument_box);
-			packed_dot = true;
-		}
+// Same argument count rules as make_lambda_macro_application()
+bool has_macro_arity(const LispNodeRC &parameters, Box *arguments) {
+	Box *current_parameter_box = parameters->get_head_pointer();
+	Box *current_argument_box = arguments;
 
-		if(is_macro) {
-			new_expression = make_substitution(parameter, argument, new_expression);
-		}
-		else {
-			// Note that argument has been already evaluated in the old environment
-			new_environment = make_cons(make2(parameter, argument), new_environment);
+	while(current_parameter_box != nullptr || current_argument_box != nullptr) {
+		if(current_parameter_box == nullptr || current_argument_box == nullptr) {
+			return false;
 		}
 
-		if(packed_dot) {
-			break;
+		if(current_parameter_box->item == symbol_dot) {
+			return true;
 		}
 
 		current_parameter_box = current_parameter_box->get_next_pointer();
 		current_argument_box = current_argument_box->get_next_pointer();
 	}
 
-	// new_expression is only different from expression if macro substitution is done
-	// new_environment is only different from environment if closure application is done
-	return make2(new_expression, new_environment);
+	return true;
 }
 
-// VM data structures, variables and functions
+LispNodeRC make_expansion(const LispNodeRC &macro, Box *arguments) {
+	LispNodeRC application = make_lambda_macro_application(make_cons(macro, LispNode::make_list(arguments)), list_empty);
 
-struct VMStackFrame {
-	int op;
-	LispNodeRC input;
-	LispNodeRC environment;
-	LispNodeRC extra1;
+	const LispNodeRC &body = application->head->item;
 
-	union State {
-		struct Apply {
-			bool closure_mode;
-			bool waiting;
-			unsigned int arity;
+	// Applications run the body in a begin, which keeps definitions local to it
+	if(body->head->next == nullptr && !has_local_definitions(body->head->item)) {
+		return body->head->item;
+	}
 
-			Apply(bool closure_mode, bool waiting, unsigned int arity): closure_mode{closure_mode}, waiting{waiting}, arity{arity} {}
-		} apply;
+	return make_cons(make_operator(OP_BEGIN), body);
+}
 
-		struct First {
-			bool waiting;
+void expand_macros(LispNodeRC &expression, const LispNodeRC &scope, unsigned int depth) {
+	if(expression->is_atom() || expression->head == nullptr) {
+		return;
+	}
 
-			First(bool waiting): waiting{waiting} {}
-		} first;
+	const LispNodeRC &first = expression->head->item;
+	Box *arguments = expression->get_head_pointer()->get_next_pointer();
 
-		struct Normal {
-			unsigned int arity;
+	if(first->is_operator()) {
+		switch(first->number_i) {
+			case OP_QUOTE:
+			case OP_LAMBDA:
+			case OP_MACRO:
+			case OP_CLOSURE:
+				// Nested lambdas expand their own bodies when they are resolved
+				return;
+			case OP_COND:
+				for(Box *current_pair_box = arguments; current_pair_box != nullptr; current_pair_box = current_pair_box->get_next_pointer()) {
+					if(current_pair_box->item->is_list()) {
+						for(Box *current_box = current_pair_box->item->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+							expand_macros(current_box->item, scope, depth);
+						}
+					}
+				}
 
-			Normal(unsigned int arity): arity{arity} {}
-		} normal;
+				return;
+			case OP_LET:
+			case OP_LET_STAR:
+			case OP_LETREC:
+				if(count_members(expression) >= 3 && has_valid_bindings(arguments->item)) {
+					// The names shadow macros in the values (for letrec) and in the body
+					LispNodeRC inner_scope = scope;
+
+					for(Box *current_binding_box = arguments->item->get_head_pointer(); current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+						inner_scope = make_cons(current_binding_box->item->head->item, inner_scope);
+					}
 
-		struct Quote {
-			Quote() {}
-		} quote;
+					for(Box *current_binding_box = arguments->item->get_head_pointer(); current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+						expand_macros(current_binding_box->item->head->next->item, inner_scope, depth);
+					}
 
-		struct Cond {
-			bool waiting;
+					for(Box *current_box = arguments->get_next_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+						expand_macros(current_box->item, inner_scope, depth);
+					}
+				}
 
-			Cond(bool waiting): waiting{waiting} {}
-		} cond;
+				return;
+			case OP_DEFINE:
+			case OP_SET_E:
+				// The target name (or the signature of a defined lambda) is not evaluated
+				if(arguments != nullptr) {
+					arguments = arguments->get_next_pointer();
+				}
 
-		struct Logic {
-			int type;
-			bool waiting;
+				break;
+		}
+	}
+	else if(first->is_pure() && scope_offset(first, scope) == -1) {
+		const LispNodeRC &global_value = first->symbol->value;
+
+		if(global_value != nullptr && global_value->is_operation(OP_MACRO)) {
+			// Otherwise the arguments are left as they are: they are unevaluated code for the macro
+			if(depth < MAXIMUM_EXPANSION_DEPTH && has_macro_arity(global_value->head->next->item, arguments)) {
+				LispNodeRC expansion = make_expansion(global_value, arguments);
+
+				expression = expansion;
+				expand_macros(expression, scope, depth + 1);
+			}
+
+			return;
+		}
+
+		arguments = expression->get_head_pointer();
+	}
+	else {
+		arguments = expression->get_head_pointer();
+	}
+
+	for(Box *current_box = arguments; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		expand_macros(current_box->item, scope, depth);
+	}
+}
+
+void resolve_lambda(const LispNodeRC &lambda, const LispNodeRC &outer_scope);
+
+#ifdef BYTECODE
+void compile_lambda(const LispNodeRC &lambda);
+#endif /* BYTECODE */
+
+void resolve_expression(LispNodeRC &expression, const LispNodeRC &scope);
+
+// The names are bound in order, as in closure applications
+void resolve_let(const LispNodeRC &expression, const LispNodeRC &scope) {
+	// Malformed forms are reported when evaluated
+	if(count_members(expression) < 3 || !has_valid_bindings(expression->head->next->item)) {
+		return;
+	}
+
+	int type = expression->head->item->number_i;
+
+	Box *bindings = expression->head->next->item->get_head_pointer();
+	Box *body = expression->get_head_pointer()->get_next_pointer()->get_next_pointer();
+
+	LispNodeRC inner_scope = scope;
+
+	if(type == OP_LETREC) {
+		for(Box *current_binding_box = bindings; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+			inner_scope = make_cons(current_binding_box->item->head->item, inner_scope);
+		}
+	}
+
+	for(Box *current_binding_box = bindings; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+		resolve_expression(current_binding_box->item->head->next->item, (type == OP_LET ? scope : inner_scope));
+
+		if(type != OP_LETREC) {
+			inner_scope = make_cons(current_binding_box->item->head->item, inner_scope);
+		}
+	}
+
+	for(Box *current_box = body; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		resolve_expression(current_box->item, inner_scope);
+	}
+}
+
+void resolve_expression(LispNodeRC &expression, const LispNodeRC &scope) {
+	if(expression->is_atom()) {
+		if(expression->is_pure()) {
+			int offset = scope_offset(expression, scope);
+
+			if(offset != -1) {
+				expression = LispNode::make_local(expression, offset);
+			}
+		}
+
+		return;
+	}
+
+	if(expression->head == nullptr) {
+		return;
+	}
+
+	const LispNodeRC &first = expression->head->item;
+	Box *arguments = expression->get_head_pointer()->get_next_pointer();
+
+	if(first->is_operator()) {
+		switch(first->number_i) {
+			case OP_QUOTE:
+			case OP_MACRO:
+			case OP_CLOSURE:
+				return;
+			case OP_LAMBDA:
+				if(first.get_pointer() != operator_lambda_resolved.get_pointer()) {
+					resolve_lambda(expression, scope);
+				}
+
+				return;
+			case OP_COND:
+				for(Box *current_pair_box = arguments; current_pair_box != nullptr; current_pair_box = current_pair_box->get_next_pointer()) {
+					if(current_pair_box->item->is_list()) {
+						for(Box *current_box = current_pair_box->item->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+							resolve_expression(current_box->item, scope);
+						}
+					}
+				}
+
+				return;
+			case OP_LET:
+			case OP_LET_STAR:
+			case OP_LETREC:
+				resolve_let(expression, scope);
+
+				return;
+			case OP_SET_E:
+				// The target name is not evaluated
+				if(arguments != nullptr) {
+					arguments = arguments->get_next_pointer();
+				}
+
+				break;
+		}
+	}
+	else if(first->is_pure() && scope_offset(first, scope) == -1) {
+		// Macro arguments are unevaluated code, which the macro may inspect
+		const LispNodeRC &global_value = first->symbol->value;
+
+		if(global_value != nullptr && global_value->is_operation(OP_MACRO)) {
+			return;
+		}
+
+		arguments = expression->get_head_pointer();
+	}
+	else {
+		arguments = expression->get_head_pointer();
+	}
+
+	for(Box *current_box = arguments; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		resolve_expression(current_box->item, scope);
+	}
+}
+
+// Rewrites the lambda in place, so it must be code from the reader or a private copy of data
+// (eval and computed operators evaluate copies)
+void resolve_lambda(const LispNodeRC &lambda, const LispNodeRC &outer_scope) {
+	// Malformed lambdas are reported by eval_procedure() when evaluated
+	if(count_members(lambda) < 3 || !lambda->head->next->item->is_list()) {
+		return;
+	}
+
+	lambda->head->item = operator_lambda_resolved;
+
+	Box *body = lambda->get_head_pointer()->get_next_pointer()->get_next_pointer();
+
+	// Parameters are bound in order, so the last one ends up first in the environment
+	LispNodeRC scope = outer_scope;
+
+	const LispNodeRC &parameters = lambda->head->next->item;
+
+	for(Box *current_parameter_box = parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+		if(current_parameter_box->item != symbol_dot) {
+			scope = make_cons(current_parameter_box->item, scope);
+		}
+	}
+
+	for(Box *current_box = body; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		expand_macros(current_box->item, scope, 0);
+	}
+
+	for(Box *current_box = body; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(has_local_definitions(current_box->item)) {
+			return;
+		}
+	}
+
+	for(Box *current_box = body; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		resolve_expression(current_box->item, scope);
+	}
+
+#ifdef BYTECODE
+	compile_lambda(lambda);
+#endif /* BYTECODE */
+}
+
+#ifdef BYTECODE
+// Bytecode compilation
+//
+// A resolved closure body is compiled into a bytecode array, which an OP_VM_CODE frame runs
+// with a single instruction pointer instead of pushing frames for each subexpression.
+// Arguments stay in the data stack, where parameters are read by slot, unless a nested lambda
+// may capture them (then they are bound in the environment, as in make_lambda_macro_application()).
+// Calls in tail position reuse the frame.
+//
+// The code atom is kept as the first item of the lambda body: as any other atom, it evaluates
+// to itself, so the tree-walking VM can still run the same lambda. As with the rest of the
+// resolution, the lambda is never user data (see resolve_lambda()). Bodies that use forms not
+// handled here (define, eval, load, apply, current-environment and macros) are not compiled.
+
+#ifdef TARGET_6502
+constexpr unsigned int MAXIMUM_LET_SLOTS = 8;
+#else
+constexpr unsigned int MAXIMUM_LET_SLOTS = 32;
+#endif /* TARGET_6502 */
+
+struct BytecodeCompiler {
+	Bytecode *code;
+	unsigned int depth;
+
+	// Names bound by the enclosing lets (innermost last), and the data stack slots holding them
+	const LispNodeRC *let_names[MAXIMUM_LET_SLOTS];
+	unsigned int let_slots[MAXIMUM_LET_SLOTS];
+	unsigned int number_let_slots;
+
+	BytecodeCompiler(Bytecode *code, unsigned int depth): code{code}, depth{depth}, number_let_slots{0} {
+	}
+
+	// Emits an operation, tracking the data stack entries it pushes or pops
+	void emit(BytecodeOperation operation, int stack_effect) {
+		code->emit(operation);
+
+		depth += stack_effect;
+
+		if(depth > code->maximum_stack) {
+			code->maximum_stack = depth;
+		}
+	}
+};
+
+bool has_nested_lambdas(const LispNodeRC &expression) {
+	if(expression->is_atom() || expression->head == nullptr) {
+		return false;
+	}
+
+	const LispNodeRC &first = expression->head->item;
+
+	if(first->is_operator()) {
+		switch(first->number_i) {
+			case OP_QUOTE:
+				return false;
+			case OP_LAMBDA:
+				return true;
+		}
+	}
+
+	for(Box *current_box = expression->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(has_nested_lambdas(current_box->item)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool has_valid_parameters(const LispNodeRC &parameters) {
+	for(Box *current_parameter_box = parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+		const LispNodeRC &parameter = current_parameter_box->item;
+
+		if(!parameter->is_atom() || !parameter->is_pure()) {
+			return false;
+		}
+
+		// A dot is followed by exactly one name, which receives the remaining arguments
+		if(parameter == symbol_dot) {
+			Box *packed_parameter_box = current_parameter_box->get_next_pointer();
+
+			if(packed_parameter_box == nullptr || packed_parameter_box->get_next_pointer() != nullptr || packed_parameter_box->item == symbol_dot) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int parameter_slot(const Bytecode *code, const LispNodeRC &symbol) {
+	int slot = -1;
+	int current_slot = 0;
+
+	// The last parameter with a given name shadows the others
+	for(Box *current_parameter_box = code->parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+		const LispNodeRC &parameter = current_parameter_box->item;
+
+		if(parameter == symbol_dot) {
+			continue;
+		}
+
+		if(parameter.get_pointer() == symbol.get_pointer()) {
+			slot = current_slot;
+		}
+
+		current_slot++;
+	}
+
+	return slot;
+}
+
+int local_slot(const BytecodeCompiler &compiler, const LispNodeRC &symbol) {
+	for(unsigned int i = compiler.number_let_slots; i > 0; i--) {
+		if(compiler.let_names[i - 1]->get_pointer() == symbol.get_pointer()) {
+			return compiler.let_slots[i - 1];
+		}
+	}
+
+	return parameter_slot(compiler.code, symbol);
+}
+
+// List of (name slot) for the let bindings in scope, outermost first
+LispNodeRC make_let_scope(const BytecodeCompiler &compiler) {
+	LispNodeRC let_scope = list_empty;
+
+	for(unsigned int i = compiler.number_let_slots; i > 0; i--) {
+		let_scope = make_cons(make2(*compiler.let_names[i - 1], LispNode::make_integer(compiler.let_slots[i - 1])), let_scope);
+	}
+
+	return let_scope;
+}
+
+bool compile_expression(BytecodeCompiler &compiler, const LispNodeRC &expression, bool tail);
+bool compile_set(BytecodeCompiler &compiler, const LispNodeRC &symbol, const LispNodeRC &value);
+
+void compile_constant(BytecodeCompiler &compiler, const LispNodeRC &constant) {
+	compiler.emit(BC_CONSTANT, 1);
+	compiler.code->emit(compiler.code->add_constant(constant));
+}
+
+void compile_patch(Bytecode *code, unsigned int chain) {
+	// Unpatched jumps are chained through their targets (position 0 always holds an opcode)
+	while(chain != 0) {
+		unsigned int previous = code->instructions[chain];
+
+		code->instructions[chain] = code->length;
+		chain = previous;
+	}
+}
+
+bool compile_sequence(BytecodeCompiler &compiler, Box *items, bool tail) {
+	if(items == nullptr) {
+		compile_constant(compiler, list_empty);
+
+		return true;
+	}
+
+	for(Box *current_box = items; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		bool last_item = (current_box->get_next_pointer() == nullptr);
+
+		if(!compile_expression(compiler, current_box->item, tail && last_item)) {
+			return false;
+		}
+
+		if(!last_item) {
+			compiler.emit(BC_POP, -1);
+		}
+	}
+
+	return true;
+}
+
+bool compile_cond(BytecodeCompiler &compiler, Box *pairs, bool tail) {
+	Bytecode *code = compiler.code;
+
+	unsigned int end_chain = 0;
+
+	for(Box *current_pair_box = pairs; current_pair_box != nullptr; current_pair_box = current_pair_box->get_next_pointer()) {
+		const LispNodeRC &current_pair = current_pair_box->item;
+
+		if(!current_pair->is_list() || current_pair->head == nullptr) {
+			return false;
+		}
+
+		if(!compile_expression(compiler, current_pair->head->item, false)) {
+			return false;
+		}
+
+		compiler.emit(BC_JUMP_UNLESS_TRUE, -1);
+		unsigned int next_pair = code->emit(0);
+
+		// No consequent: just evaluate to the empty list
+		if(!compile_sequence(compiler, current_pair->get_head_pointer()->get_next_pointer(), tail)) {
+			return false;
+		}
+
+		// The value is carried to the end, so the next pair starts at the same depth
+		compiler.emit(BC_JUMP, -1);
+		end_chain = code->emit(end_chain);
+
+		code->instructions[next_pair] = code->length;
+	}
+
+	compile_constant(compiler, list_empty);
+	compile_patch(code, end_chain);
+
+	return true;
+}
+
+bool compile_if(BytecodeCompiler &compiler, Box *arguments, bool tail) {
+	Bytecode *code = compiler.code;
+
+	unsigned int number_arguments = 0;
+
+	for(Box *current_box = arguments; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		number_arguments++;
+	}
+
+	if(number_arguments != 2 && number_arguments != 3) {
+		return false;
+	}
+
+	if(!compile_expression(compiler, arguments->item, false)) {
+		return false;
+	}
+
+	compiler.emit(BC_JUMP_UNLESS_TRUE, -1);
+	unsigned int alternative = code->emit(0);
+
+	if(!compile_expression(compiler, arguments->next->item, tail)) {
+		return false;
+	}
+
+	// The value is carried to the end, so the alternative starts at the same depth
+	compiler.emit(BC_JUMP, -1);
+	unsigned int end = code->emit(0);
+
+	code->instructions[alternative] = code->length;
+
+	if(number_arguments == 3) {
+		if(!compile_expression(compiler, arguments->next->next->item, tail)) {
+			return false;
+		}
+	}
+	else {
+		compile_constant(compiler, list_empty);
+	}
+
+	code->instructions[end] = code->length;
+
+	return true;
+}
+
+// Each name gets the data stack slot where its value was pushed, until the body leaves its value
+// on top of them (the slots are then dropped). In environment mode, the tree-walking VM runs it.
+bool compile_let(BytecodeCompiler &compiler, int type, const LispNodeRC &expression, bool tail) {
+	Bytecode *code = compiler.code;
+
+	if(code->environment_mode || count_members(expression) < 3 || !has_valid_bindings(expression->head->next->item)) {
+		return false;
+	}
+
+	Box *bindings = expression->head->next->item->get_head_pointer();
+	Box *body = expression->get_head_pointer()->get_next_pointer()->get_next_pointer();
+
+	unsigned int outer_number_let_slots = compiler.number_let_slots;
+	unsigned int number_bindings = count_members(expression->head->next->item);
+
+	if(outer_number_let_slots + number_bindings > MAXIMUM_LET_SLOTS) {
+		return false;
+	}
+
+	// Same scopes as in resolve_let()
+	for(Box *current_binding_box = bindings; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+		if(type == OP_LETREC) {
+			compile_constant(compiler, list_empty);
+		}
+		else if(!compile_expression(compiler, current_binding_box->item->head->next->item, false)) {
+			return false;
+		}
+
+		if(type != OP_LET) {
+			compiler.let_names[compiler.number_let_slots] = &current_binding_box->item->head->item;
+			compiler.let_slots[compiler.number_let_slots] = compiler.depth - 1;
+			compiler.number_let_slots++;
+		}
+	}
+
+	if(type == OP_LET) {
+		unsigned int slot = compiler.depth - number_bindings;
+
+		for(Box *current_binding_box = bindings; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+			compiler.let_names[compiler.number_let_slots] = &current_binding_box->item->head->item;
+			compiler.let_slots[compiler.number_let_slots] = slot++;
+			compiler.number_let_slots++;
+		}
+	}
+
+	if(type == OP_LETREC) {
+		for(Box *current_binding_box = bindings; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+			if(!compile_set(compiler, current_binding_box->item->head->item, current_binding_box->item->head->next->item)) {
+				return false;
+			}
+
+			compiler.emit(BC_POP, -1);
+		}
+	}
+
+	bool success = compile_sequence(compiler, body, tail);
+
+	compiler.number_let_slots = outer_number_let_slots;
+
+	if(!success) {
+		return false;
+	}
+
+	compiler.emit(BC_SLIDE, -(int) number_bindings);
+	code->emit(number_bindings);
+
+	return true;
+}
+
+bool compile_logic(BytecodeCompiler &compiler, int type, Box *items, bool tail) {
+	Bytecode *code = compiler.code;
+
+	if(items == nullptr) {
+		compile_constant(compiler, (type == OP_AND ? atom_true : atom_false));
+
+		return true;
+	}
+
+	unsigned int end_chain = 0;
+
+	for(Box *current_box = items; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		bool last_item = (current_box->get_next_pointer() == nullptr);
+
+		if(!compile_expression(compiler, current_box->item, tail && last_item)) {
+			return false;
+		}
+
+		if(!last_item) {
+			compiler.emit((type == OP_AND ? BC_AND : BC_OR), -1);
+			end_chain = code->emit(end_chain);
+		}
+	}
+
+	compile_patch(code, end_chain);
+
+	return true;
+}
+
+bool compile_set(BytecodeCompiler &compiler, const LispNodeRC &symbol, const LispNodeRC &value) {
+	Bytecode *code = compiler.code;
+
+	if(!symbol->is_atom() || !symbol->is_pure()) {
+		return false;
+	}
+
+	if(!compile_expression(compiler, value, false)) {
+		return false;
+	}
+
+	int slot = (code->environment_mode ? -1 : local_slot(compiler, symbol));
+
+	if(slot != -1) {
+		compiler.emit(BC_SET_LOCAL, 0);
+		code->emit(slot);
+		code->emit(code->add_constant(symbol));
+	}
+	else {
+		compiler.emit(BC_SET, 0);
+		code->emit(code->add_constant(symbol));
+	}
+
+	return true;
+}
+
+bool compile_call(BytecodeCompiler &compiler, const LispNodeRC &expression, bool tail) {
+	Bytecode *code = compiler.code;
+
+	const LispNodeRC &first = expression->head->item;
+	Box *arguments = expression->get_head_pointer()->get_next_pointer();
+
+	if(!compile_expression(compiler, first, false)) {
+		return false;
+	}
+
+	// Checked at runtime, as the callee could become a macro after this compilation
+	compiler.emit(BC_CHECK_CALLEE, 0);
+	code->emit(code->add_constant(expression));
+	unsigned int check_target = code->emit(0);
+	code->emit(code->add_constant(make_let_scope(compiler)));
+
+	unsigned int arity = 0;
+
+	for(Box *current_box = arguments; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(!compile_expression(compiler, current_box->item, false)) {
+			return false;
+		}
+
+		arity++;
+	}
+
+	compiler.emit((tail ? BC_TAIL_CALL : BC_CALL), -(int) arity);
+	code->emit(arity);
+	code->emit(code->add_constant(expression));
+
+	code->instructions[check_target] = code->length;
+
+	// A tail call only falls through when the callee is an operator, or when the
+	// tree-walking VM evaluated the expression instead
+	if(tail) {
+		compiler.emit(BC_RETURN, 0);
+	}
+
+	return true;
+}
+
+bool compile_expression(BytecodeCompiler &compiler, const LispNodeRC &expression, bool tail) {
+	Bytecode *code = compiler.code;
+
+	if(expression->is_atom()) {
+		if(expression->is_local()) {
+			unsigned int offset = expression->local->offset;
+
+			if(code->environment_mode) {
+				compiler.emit(BC_ENVIRONMENT, 1);
+				code->emit(code->add_constant(expression));
+			}
+			else if(offset < compiler.number_let_slots) {
+				// The innermost let binding has offset 0
+				compiler.emit(BC_LOCAL, 1);
+				code->emit(compiler.let_slots[compiler.number_let_slots - 1 - offset]);
+			}
+			else if(offset - compiler.number_let_slots < code->number_parameters) {
+				// Parameters are bound in order, so the last one has offset 0
+				compiler.emit(BC_LOCAL, 1);
+				code->emit(code->number_parameters - 1 - (offset - compiler.number_let_slots));
+			}
+			else {
+				// The parameters are not in the environment of the frame, only the captured one
+				compiler.emit(BC_ENVIRONMENT, 1);
+				code->emit(code->add_constant(LispNode::make_local(expression->local->symbol, offset - compiler.number_let_slots - code->number_parameters)));
+			}
+
+			return true;
+		}
+
+		if(expression->is_pure()) {
+			compiler.emit(BC_LOOKUP, 1);
+			code->emit(code->add_constant(expression));
+
+			return true;
+		}
+
+		compile_constant(compiler, expression);
+
+		return true;
+	}
+
+	// Errors are left for the tree-walking VM to report
+	if(expression->head == nullptr) {
+		return false;
+	}
+
+	const LispNodeRC &first = expression->head->item;
+	Box *arguments = expression->get_head_pointer()->get_next_pointer();
+
+	unsigned int number_arguments = count_members(expression) - 1;
+
+	if(first->is_operator()) {
+		int operation_index = first->number_i;
+		ReduceMode operation_reduce_mode = operation_index >= 0 ? operator_reduce_modes[operation_index] : Unspecified;
+
+		switch(operation_reduce_mode) {
+			case SpecialQuote:
+				if(number_arguments != 1) {
+					return false;
+				}
+
+				compile_constant(compiler, arguments->item);
+
+				return true;
+
+			case SpecialCond:
+				return compile_cond(compiler, arguments, tail);
+
+			case SpecialLogic:
+				return compile_logic(compiler, operation_index, arguments, tail);
+
+			case SpecialBegin:
+				return compile_sequence(compiler, arguments, tail);
+
+			case SpecialIf:
+				return compile_if(compiler, arguments, tail);
+
+			case SpecialLet:
+				return compile_let(compiler, operation_index, expression, tail);
+
+			case SpecialDefine:
+				if(operation_index != OP_SET_E || number_arguments != 2) {
+					return false;
+				}
+
+				return compile_set(compiler, arguments->item, arguments->next->item);
+
+			case Normal0:
+			case Normal1:
+			case Normal2:
+			case Normal3:
+			case NormalX:
+				// Needs the environment as a list
+				if(operation_index == OP_CURRENT_ENVIRONMENT || !is_native_procedure(operation_index)) {
+					return false;
+				}
+
+				if(operation_reduce_mode != NormalX && number_arguments != (unsigned int) (operation_reduce_mode - Normal0)) {
+					return false;
+				}
+
+				for(Box *current_box = arguments; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+					if(!compile_expression(compiler, current_box->item, false)) {
+						return false;
+					}
+				}
+
+				compiler.emit(BC_OPERATOR, 1 - (int) number_arguments);
+				code->emit(operation_index);
+				code->emit(number_arguments);
+				code->emit(code->add_constant(expression));
+
+				return true;
+
+			case ImmediateLambda:
+				// Nested lambdas were resolved (and compiled, if possible) along with this one
+				if(first.get_pointer() != operator_lambda_resolved.get_pointer() || !has_valid_parameters(arguments->item)) {
+					return false;
+				}
+
+				compiler.emit(BC_CLOSURE, 1);
+				code->emit(code->add_constant(expression));
+
+				return true;
+
+			default:
+				return false;
+		}
+	}
+
+	if((first->is_atom() && !first->is_pure() && !first->is_local()) || first->is_operation(OP_CLOSURE) || first->is_operation(OP_MACRO)) {
+		return false;
+	}
+
+	// Macros take their arguments unevaluated
+	if(first->is_pure()) {
+		const LispNodeRC &global_value = first->symbol->value;
+
+		if(global_value != nullptr && global_value->is_operation(OP_MACRO)) {
+			return false;
+		}
+	}
+
+	return compile_call(compiler, expression, tail);
+}
+
+void compile_lambda(const LispNodeRC &lambda) {
+	const LispNodeRC &parameters = lambda->head->next->item;
+
+	if(!has_valid_parameters(parameters)) {
+		return;
+	}
+
+	Box *parameters_box = lambda->get_head_pointer()->get_next_pointer();
+	Box *body = parameters_box->get_next_pointer();
+
+	Bytecode *code = new Bytecode(parameters);
+
+	for(Box *current_parameter_box = parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+		if(current_parameter_box->item == symbol_dot) {
+			code->packed_dot = true;
+		}
+		else {
+			code->number_parameters++;
+		}
+	}
+
+	for(Box *current_box = body; current_box != nullptr; current_box = current_box->get_next_pointer()) {
+		if(has_nested_lambdas(current_box->item)) {
+			code->environment_mode = true;
+		}
+	}
+
+	BytecodeCompiler compiler{code, (code->environment_mode ? 0 : code->number_parameters)};
+
+	code->maximum_stack = compiler.depth;
+
+	bool success = compile_sequence(compiler, body, true);
+
+	compiler.emit(BC_RETURN, 0);
+
+	// Operands are 16 bits wide
+	if(!success || code->length > UINT16_MAX || code->number_constants > UINT16_MAX) {
+		delete code;
+
+		return;
+	}
+
+	LispNode *code_atom = new LispNode(LispType::AtomCode);
+	code_atom->code = code;
+
+	parameters_box->next = new Box(code_atom, parameters_box->next);
+}
+#endif /* BYTECODE */
+
+LispNodeRC eval_lambda(const LispNodeRC &input, const LispNodeRC &environment) {
+	if(eval_procedure(input, environment) == list_empty) {
+		return nullptr;
+	}
+
+	// Lambdas nested in a resolved body were already resolved along with it
+	if(input->head->item.get_pointer() != operator_lambda_resolved.get_pointer()) {
+		resolve_lambda(input, list_empty);
+	}
+
+	return make4(make_operator(OP_CLOSURE), list_empty, input, environment);
+}
+
+LispNodeRC eval_local(const LispNodeRC &input, const LispNodeRC &environment) {
+	unsigned int offset = input->local->offset;
+	const LispNodeRC &symbol = input->local->symbol;
+
+	Box *current_definition_box = environment->get_head_pointer();
+
+	for(unsigned int i = 0; i < offset && current_definition_box != nullptr; i++) {
+		current_definition_box = current_definition_box->get_next_pointer();
+	}
+
+	if(current_definition_box != nullptr) {
+		const LispNodeRC &current_pair = current_definition_box->item;
+
+		if(current_pair->head->item.get_pointer() == symbol.get_pointer()) {
+			return current_pair->head->next->item;
+		}
+	}
+
+	return lookup_symbol(symbol, environment);
+}
+
+#ifndef SEPARATE_FRAMES
+inline const LispNodeRC &make_environment(const LispNodeRC &environment) {
+	return environment;
+}
+#else
+LispNodeRC make_environment(const LispNodeRC &environment) {
+	// Creates an environment with a dummy entry to separate frames
+	LispNodeRC new_environment = make_cons(make2(atom_false, atom_false), environment);
+
+	return new_environment;
+}
+#endif /* SEPARATE_FRAMES */
+
+LispNodeRC make_lambda_macro_application(const LispNodeRC &input, const LispNodeRC &environment) {
+	const LispNodeRC &closure_or_macro = input->head->item;
+
+	int operator_index = closure_or_macro->head->item->number_i;
+
+	// Defines if we operate on macro substitution mode or in closure application mode
+	bool is_closure = (operator_index == OP_CLOSURE);
+	bool is_macro = (operator_index == OP_MACRO);
+
+	const LispNodeRC &procedure = (is_closure ? closure_or_macro->head->next->next->item : closure_or_macro);
+	const LispNodeRC &procedure_parameters = procedure->head->next->item;
+
+	// Evaluate the function by setting a new environment for the defined parameters
+
+	// Used when is_macro == #t:
+	//     Macro expansion: substitutes non-evaluated parameters into arguments in the original expression
+	LispNodeRC new_expression = LispNode::make_list(procedure->get_head_pointer()->get_next_pointer()->get_next_pointer());
+	LispNodeRC substitutions = list_empty;
+	// Used when is_macro == #f:
+	//     Eager evaluation: creates a new environment binding parameters to their eagerly-evaluated arguments
+	LispNodeRC new_environment = (is_closure ? make_environment(closure_or_macro->head->next->next->next->item) : environment);
+
+	if(is_closure) {
+		const LispNodeRC &closure_name = closure_or_macro->head->next->item;
+
+		// Global closures reach themselves through the symbol value cell, so only local ones need this
+		if(closure_name != list_empty && closure_name->symbol->value.get_pointer() != closure_or_macro.get_pointer() && make_query_optional_replace(closure_name, new_environment) == nullptr) {
+			new_environment = make_cons(make2(closure_name, closure_or_macro), new_environment);
+		}
+	}
+
+	bool packed_dot = false;
+
+	Box *current_parameter_box = procedure_parameters->get_head_pointer();
+	Box *current_argument_box = input->get_head_pointer()->get_next_pointer();
+
+	while(current_parameter_box != nullptr || current_argument_box != nullptr) {
+		if(current_parameter_box == nullptr || current_argument_box == nullptr) {
+			print_error("operator application", "missing or extra arguments\n");
+
+			return nullptr;
+		}
+
+		// Evaluate the argument using the old environment
+		LispNodeRC parameter = current_parameter_box->item;
+		LispNodeRC argument = current_argument_box->item;
+
+		if(parameter == symbol_dot) {
+			// Get the name of the other parameters and bind them into a list
+			current_parameter_box = current_parameter_box->get_next_pointer();
+			parameter = current_parameter_box->item;
+			
+			argument = LispNode::make_list(current_argument_box);
+			packed_dot = true;
+		}
+
+		if(is_macro) {
+			// The caller may have been resolved before the macro was defined
+			substitutions = make_cons(make2(parameter, make_unresolved(argument)), substitutions);
+		}
+		else {
+			// Note that argument has been already evaluated in the old environment
+			new_environment = make_cons(make2(parameter, argument), new_environment);
+		}
+
+		if(packed_dot) {
+			break;
+		}
+
+		current_parameter_box = current_parameter_box->get_next_pointer();
+		current_argument_box = current_argument_box->get_next_pointer();
+	}
+
+	// The expansion is resolved in place when evaluated, so it cannot share lists with the macro body
+	if(is_macro) {
+		new_expression = make_substitution(substitutions, new_expression, false);
+	}
+
+	// new_expression is only different from expression if macro substitution is done
+	// new_environment is only different from environment if closure application is done
+	return make2(new_expression, new_environment);
+}
+
+// VM data structures, variables and functions
+
+struct VMStackFrame {
+	int op;
+	LispNodeRC input;
+	LispNodeRC environment;
+	LispNodeRC extra1;
+
+	union State {
+		struct Apply {
+			bool closure_mode;
+			bool waiting;
+			unsigned int arity;
+
+			Apply(bool closure_mode, bool waiting, unsigned int arity): closure_mode{closure_mode}, waiting{waiting}, arity{arity} {}
+		} apply;
+
+		struct First {
+			bool waiting;
+
+			First(bool waiting): waiting{waiting} {}
+		} first;
+
+		struct Normal {
+			unsigned int arity;
+
+			Normal(unsigned int arity): arity{arity} {}
+		} normal;
+
+		struct Quote {
+			Quote() {}
+		} quote;
+
+		struct Cond {
+			bool waiting;
+
+			Cond(bool waiting): waiting{waiting} {}
+		} cond;
+
+		struct Logic {
+			int type;
+			bool waiting;
 
 			Logic(int type, bool waiting): type{type}, waiting{waiting} {}
 		} logic;
 
-		struct Define {
-			int type;
-			bool waiting;
+		struct Define {
+			int type;
+			bool waiting;
+
+			Define(int type, bool waiting): type{type}, waiting{waiting} {}
+		} define;
+
+		struct Begin {
+			bool waiting;
+			LispNodeRC *saved_context_environment;
+
+			Begin(bool waiting, LispNodeRC *saved_context_environment): waiting{waiting}, saved_context_environment{saved_context_environment} {}
+		} begin;
+
+		struct If {
+			bool waiting;
+
+			If(bool waiting): waiting{waiting} {}
+		} if_else;
+
+		struct Let {
+			int type;
+			bool waiting;
+			Box *binding_box;
+
+			Let(int type, bool waiting, Box *binding_box): type{type}, waiting{waiting}, binding_box{binding_box} {}
+		} let;
+
+		struct Eval {
+			Eval() {}
+		} eval;
+
+		struct Load {
+			int type;
+			bool waiting;
+
+			Load(int type, bool waiting): type{type}, waiting{waiting} {}
+		} load;
+
+		struct Call {
+			unsigned int arity;
+
+			Call(unsigned int arity): arity{arity} {}
+		} call;
+
+		struct EvalList {
+			bool discard_intermediary;
+			bool waiting;
+
+			EvalList(bool discard_intermediary, bool waiting): discard_intermediary{discard_intermediary}, waiting{waiting} {}
+		} eval_list;
+
+		struct Code {
+			unsigned int ip;
+			unsigned int base;
+
+			Code(unsigned int ip, unsigned int base): ip{ip}, base{base} {}
+		} code;
+
+		State(): apply{false, false, 0} {}
+
+		~State() {
+		}
+
+		State(const Apply &apply): apply{apply} {}
+		State(const First &first): first{first} {}
+		State(const Normal &normal): normal{normal} {}
+		// The empty states still initialize the union, which is copied as a whole
+		State(const Quote &): apply{false, false, 0} {}
+		State(const Cond &cond): cond{cond} {}
+		State(const Logic &logic): logic{logic} {}
+		State(const Define &define): define{define} {}
+		State(const Begin &begin): begin{begin} {}
+		State(const If &if_else): if_else{if_else} {}
+		State(const Let &let): let{let} {}
+		State(const Eval &): apply{false, false, 0} {}
+		State(const Load &load): load{load} {}
+		State(const Call &call): call{call} {}
+		State(const EvalList &eval_list): eval_list{eval_list} {}
+		State(const Code &code): code{code} {}
+	} vm_state;
+
+	VMStackFrame(): op(0), input(nullptr), environment(nullptr), vm_state{State(State::Eval())} {}
+	VMStackFrame(int op, const LispNodeRC &input, const LispNodeRC &environment, const State &vm_state): op(op), input(input), environment(environment), vm_state{vm_state} {}
+
+	~VMStackFrame() {}
+};
+
+using VMState = VMStackFrame::State;
+
+// Both stacks grow one segment at a time, up to STACK_SEGMENTS segments each
+#ifdef TARGET_6502
+constexpr unsigned int STACK_SEGMENT_BITS = 5;
+#else
+constexpr unsigned int STACK_SEGMENT_BITS = 8;
+#endif /* TARGET_6502 */
+
+#ifndef STACK_SEGMENTS
+#ifdef TARGET_6502
+#define STACK_SEGMENTS 16
+#else
+#define STACK_SEGMENTS 4096
+#endif /* TARGET_6502 */
+#endif /* STACK_SEGMENTS */
+
+// Entries a VM operation may push before the next overflow check in vm_run()
+constexpr unsigned int STACK_SLACK = 4;
+
+SegmentedStack<VMStackFrame, STACK_SEGMENT_BITS> evaluation_stack;
+SegmentedStack<LispNodeRC, STACK_SEGMENT_BITS> data_stack;
+
+unsigned int vm_top;
+unsigned int data_top;
+
+// Tops past these need another segment
+unsigned int vm_limit;
+unsigned int data_limit;
+
+bool vm_grow() {
+	if(!evaluation_stack.grow()) {
+		return false;
+	}
+
+	vm_limit = evaluation_stack.capacity() - STACK_SLACK;
+
+	return true;
+}
+
+bool data_grow() {
+	if(!data_stack.grow()) {
+		return false;
+	}
+
+	data_limit = data_stack.capacity() - STACK_SLACK;
+
+	return true;
+}
+
+// Makes sure the data stack can hold the given number of entries
+bool data_reserve(unsigned int size) {
+	while(size >= data_limit) {
+		if(!data_grow()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void vm_push_operation(int op, const LispNodeRC &input, const LispNodeRC &environment, const VMState &state) {
+	VMStackFrame &frame = evaluation_stack[vm_top];
+
+	frame.op = op;
+	frame.input = input;
+	frame.environment = environment;
+	frame.vm_state = state;
+
+#ifdef MARK_AND_SWEEP
+	// Whatever a previous frame left here would be traced as live
+	frame.extra1 = nullptr;
+#endif /* MARK_AND_SWEEP */
+
+	vm_top++;
+}
+
+inline VMStackFrame &vm_peek() {
+	return evaluation_stack[vm_top - 1];
+}
+
+inline void vm_pop() {
+	vm_top--;
+}
+
+inline void data_push(const LispNodeRC &node) {
+	data_stack[data_top] = node;
+	data_top++;
+}
+
+inline LispNodeRC &data_peek() {
+	return data_stack[data_top - 1];
+}
+
+inline void data_pop() {
+	data_top--;
+}
+
+// Called before a closure application replaces its frame: a begin right below it has evaluated its
+// last item, so the only thing left for it is restoring the context environment (then it can go)
+//
+// This makes every closure call in tail position run in constant space, mutual recursion included
+void vm_complete_begins() {
+	while(vm_top > 0 && vm_peek().op == OP_VM_BEGIN) {
+		context_environment = vm_peek().vm_state.begin.saved_context_environment;
+		vm_pop();
+	}
+}
+
+// Arithmetic and comparisons over any number of arguments, taken directly from the data stack
+//
+// The reduction is kept in a local integer, moving to a bignum when it overflows (an error without
+// bignums), and to a real after the first real argument, so no intermediate nodes are made;
+// comparisons are chained, as in (< a b c)
+LispNodeRC eval_genX(int operation_index, unsigned int first, unsigned int arity) {
+	// Two integers: small results are immortal nodes, so most of these allocate nothing
+	if(arity == 2 && data_stack[first]->is_numeric_integral() && data_stack[first + 1]->is_numeric_integral()) {
+		Integral value1 = data_stack[first]->number_i;
+		Integral value2 = data_stack[first + 1]->number_i;
+
+		if(operation_index >= OP_LESS) {
+			return (LispNode::op_comparison_integer(operation_index, value1, value2) ? atom_true : atom_false);
+		}
+
+		if(operation_index == OP_DIVIDE && value2 == 0) {
+			return nullptr;
+		}
+
+		Integral value;
+
+		if(LispNode::op_arithmetic_integer(operation_index, value1, value2, value)) {
+			return LispNode::make_integer(value);
+		}
+
+		// Overflows are reduced again below, with bignums (or fail there without them)
+	}
+
+	for(unsigned int i = 0; i < arity; i++) {
+		if(!data_stack[first + i]->is_numeric()) {
+			return nullptr;
+		}
+	}
+
+	if(operation_index >= OP_LESS && operation_index <= OP_BIGGER_EQUAL) {
+		if(arity == 0) {
+			return nullptr;
+		}
+
+		for(unsigned int i = 1; i < arity; i++) {
+			const LispNodeRC &left = data_stack[first + i - 1];
+			const LispNodeRC &right = data_stack[first + i];
+
+			bool holds;
+
+			if(left->is_numeric_integral() && right->is_numeric_integral()) {
+				holds = LispNode::op_comparison_integer(operation_index, left->number_i, right->number_i);
+			}
+#ifdef BIGNUMS
+			else if(!left->is_numeric_real() && !right->is_numeric_real()) {
+				holds = LispNode::op_comparison_integer(operation_index, Bignum::compare(left->get_bignum(), right->get_bignum()), 0);
+			}
+#endif /* BIGNUMS */
+			else {
+				holds = LispNode::op_comparison_real(operation_index, left->get_real(), right->get_real());
+			}
+
+			if(!holds) {
+				return atom_false;
+			}
+		}
+
+		return atom_true;
+	}
+
+	if(operation_index < OP_PLUS || operation_index > OP_DIVIDE) {
+		return nullptr;
+	}
+
+	// (+) and (*) give their identities; (- x) and (/ x) start from them
+	bool is_inverse = (operation_index == OP_MINUS || operation_index == OP_DIVIDE);
+
+	if(arity == 0 && is_inverse) {
+		return nullptr;
+	}
+
+	Integral value_i = ((operation_index == OP_PLUS || operation_index == OP_MINUS) ? 0 : 1);
+#ifdef BIGNUMS
+	Bignum *value_b = nullptr;
+#endif /* BIGNUMS */
+	Real value_r = Real(0.0);
+
+	bool is_real = false;
+
+	unsigned int i = 0;
+
+	if(arity > 1 || (arity == 1 && !is_inverse)) {
+		const LispNodeRC &argument = data_stack[first];
+
+		if(argument->is_numeric_real()) {
+			value_r = argument->number_r;
+			is_real = true;
+		}
+#ifdef BIGNUMS
+		else if(argument->is_numeric_big()) {
+			value_b = new Bignum(*argument->bignum);
+		}
+#endif /* BIGNUMS */
+		else {
+			value_i = argument->number_i;
+		}
+
+		i = 1;
+	}
+
+	for(; i < arity; i++) {
+		const LispNodeRC &argument = data_stack[first + i];
+
+		if(!is_real && argument->is_numeric_real()) {
+#ifdef BIGNUMS
+			if(value_b != nullptr) {
+				value_r = value_b->get_real();
+
+				delete value_b;
+				value_b = nullptr;
+			}
+			else {
+				value_r = value_i;
+			}
+#else
+			value_r = value_i;
+#endif /* BIGNUMS */
+
+			is_real = true;
+		}
+
+		if(is_real) {
+			Real operand = argument->get_real();
+
+			if(operation_index == OP_DIVIDE && operand == Real(0.0)) {
+				return nullptr;
+			}
+
+			value_r = LispNode::op_arithmetic_real(operation_index, value_r, operand);
+
+			continue;
+		}
+
+#ifdef BIGNUMS
+		// Bignums are never zero (zero is always a plain integer)
+		if(operation_index == OP_DIVIDE && argument->is_numeric_integral() && argument->number_i == 0) {
+			delete value_b;
+
+			return nullptr;
+		}
+
+		if(value_b == nullptr && argument->is_numeric_integral() && LispNode::op_arithmetic_integer(operation_index, value_i, argument->number_i, value_i)) {
+			continue;
+		}
+
+		// A bignum argument, or an integer operation that overflowed
+		if(value_b == nullptr) {
+			value_b = new Bignum(value_i);
+		}
+
+		Bignum *next_value = LispNode::op_arithmetic_big(operation_index, *value_b, argument->get_bignum());
+
+		delete value_b;
+		value_b = next_value;
+#else
+		if(operation_index == OP_DIVIDE && argument->number_i == 0) {
+			return nullptr;
+		}
+
+		if(!LispNode::op_arithmetic_integer(operation_index, value_i, argument->number_i, value_i)) {
+			return nullptr;
+		}
+#endif /* BIGNUMS */
+	}
+
+	if(is_real) {
+		return LispNode::make_real(value_r);
+	}
+
+#ifdef BIGNUMS
+	if(value_b != nullptr) {
+		return LispNode::make_bignum(value_b);
+	}
+#endif /* BIGNUMS */
+
+	return LispNode::make_integer(value_i);
+}
+
+LispNodeRC vm_call_operator(int operation_index, unsigned int arity, const LispNodeRC &environment) {
+	unsigned int first = data_top - arity;
+
+	if(operator_reduce_modes[operation_index] == NormalX) {
+		return eval_genX(operation_index, first, arity);
+	}
+
+	switch(arity) {
+		case 0:
+			return eval_gen0(operation_index, environment);
+		case 1:
+			return eval_gen1(operation_index, data_stack[first], environment);
+		case 2:
+			return eval_gen2(operation_index, data_stack[first], data_stack[first + 1], environment);
+		case 3:
+			return eval_gen3(operation_index, data_stack[first], data_stack[first + 1], data_stack[first + 2], environment);
+	}
+
+	return nullptr;
+}
+
+void vm_finish() {
+	vm_top = 0;
+	data_top = 0;
+
+	context_environment = &global_environment;
+}
 
-			Define(int type, bool waiting): type{type}, waiting{waiting} {}
-		} define;
+void vm_reset() {
+	vm_finish();
+}
 
-		struct Begin {
-			bool waiting;
-			LispNodeRC *saved_context_environment;
+#ifdef MARK_AND_SWEEP
+// Frees every node and box the interpreter cannot reach anymore
+//
+// Only called between VM operations (and between top-level expressions), when everything live
+// is reachable from the globals, the symbol table, or the entries in use in both stacks
+void collect_garbage() {
+	GarbageCollector::setup();
 
-			Begin(bool waiting, LispNodeRC *saved_context_environment): waiting{waiting}, saved_context_environment{saved_context_environment} {}
-		} begin;
+	GarbageCollector::mark(global_environment);
+	GarbageCollector::mark(*context_environment);
+	GarbageCollector::mark(symbol_dot);
 
-		struct Eval {
-			Eval() {}
-		} eval;
+	SymbolTable::mark();
 
-		struct Load {
-			int type;
-			bool waiting;
+	for(unsigned int i = 0; i < vm_top; i++) {
+		GarbageCollector::mark(evaluation_stack[i].input);
+		GarbageCollector::mark(evaluation_stack[i].environment);
+		GarbageCollector::mark(evaluation_stack[i].extra1);
+	}
 
-			Load(int type, bool waiting): type{type}, waiting{waiting} {}
-		} load;
+	for(unsigned int i = 0; i < data_top; i++) {
+		GarbageCollector::mark(data_stack[i]);
+	}
+
+#ifdef GENERATIONAL
+	// The boxes let frames are at may have been copied out of the nursery
+	for(unsigned int i = 0; i < vm_top; i++) {
+		if(evaluation_stack[i].op == OP_VM_LET) {
+			evaluation_stack[i].vm_state.let.binding_box = GarbageCollector::relocate(evaluation_stack[i].vm_state.let.binding_box);
+		}
+	}
+#endif /* GENERATIONAL */
+
+	GarbageCollector::commit();
+}
+
+#define VM_COLLECT() \
+	if(GarbageCollector::is_due()) { \
+		collect_garbage(); \
+	}
+#elif defined(CYCLE_COLLECTOR)
+#define VM_COLLECT() \
+	if(CycleCollector::is_due()) { \
+		CycleCollector::collect(); \
+	}
+#else
+#define VM_COLLECT()
+#endif /* MARK_AND_SWEEP */
+
+// VM dispatch
+//
+// By default, vm_run() goes back to a switch after every operation. With THREADED_DISPATCH,
+// each handler jumps straight to the handler of the next operation through a table of label
+// addresses ("computed goto"), so every handler has its own indirect jump for the branch
+// predictor to learn from; eval_reduce() also jumps through a table indexed by the reduce mode.
+// Labels as values are a GNU extension (GCC and Clang), so other compilers always use the switch.
+
+#if defined(THREADED_DISPATCH) && !defined(__GNUC__)
+#undef THREADED_DISPATCH
+#endif /* THREADED_DISPATCH && !__GNUC__ */
+
+#ifdef THREADED_DISPATCH
+#define DISPATCH_CASE(value) handle_##value:
+#define DISPATCH_DEFAULT handle_default:
+#else
+#define DISPATCH_CASE(value) case value:
+#define DISPATCH_DEFAULT default:
+#endif /* THREADED_DISPATCH */
+
+// Loads the frame on top of the evaluation stack, leaving vm_run() when it is done (or overflows)
+//
+// Stacks only need to grow when a top reaches the end of its last segment
+#define VM_FETCH() \
+	if(vm_top == 0) { \
+		return true; \
+	} \
+	if(vm_top >= vm_limit && !vm_grow()) { \
+		fputs("Eval stack overflow; use tail-recursion\n", stdout); \
+		return false; \
+	} \
+	if(data_top >= data_limit && !data_grow()) { \
+		fputs("Data stack overflow; use tail-recursion\n", stdout); \
+		return false; \
+	} \
+	VM_COLLECT(); \
+	top = &vm_peek(); \
+	vm_state = &top->vm_state; \
+	input = top->input; \
+	environment = top->environment;
+
+#ifdef THREADED_DISPATCH
+#define VM_NEXT() do { VM_FETCH(); goto *vm_handlers[top->op - OP_VM_FIRST]; } while(0)
+#define VM_DISPATCH() VM_NEXT();
+#define REDUCE_DISPATCH(mode) goto *reduce_handlers[mode];
+#else
+#define VM_NEXT() continue
+#define VM_DISPATCH() VM_FETCH(); switch(top->op)
+#define REDUCE_DISPATCH(mode) switch(mode)
+#endif /* THREADED_DISPATCH */
+
+bool eval_reduce(const LispNodeRC &input, const LispNodeRC &environment) {
+	if(input->is_atom()) {
+		if(input->is_pure() || input->is_local()) {
+			LispNodeRC other_input = (input->is_local() ? eval_local(input, environment) : lookup_symbol(input, environment));
+
+			if(other_input != nullptr) {
+				data_push(other_input);
+				return true;
+			}
+
+			print_error(input, "evaluation error\n");
+			return false;
+		}
+
+		data_push(input);
+		return true;
+	}
+
+	// Input is a list...
+
+	if(input->head == nullptr) {
+		print_error("\'()", "evaluation error\n");
+		return false;
+	}
+
+	const LispNodeRC &first = input->head->item;
+
+	if(first->is_operator()) {
+		// First try one of the predefined operators
+		int operation_index = first->number_i;
+		ReduceMode operation_reduce_mode = operation_index >= 0 ? operator_reduce_modes[first->number_i] : Unspecified;
+
+#ifdef THREADED_DISPATCH
+		// Indexed by the reduce mode
+		static const void *reduce_handlers[] = {
+			&&handle_SpecialQuote,
+			&&handle_SpecialCond,
+			&&handle_SpecialLogic,
+			&&handle_SpecialBegin,
+			&&handle_SpecialIf,
+			&&handle_SpecialLet,
+			&&handle_SpecialDefine,
+			&&handle_SpecialLoad,
+			&&handle_Normal0,
+			&&handle_Normal1,
+			&&handle_Normal2,
+			&&handle_Normal3,
+			&&handle_NormalX,
+			&&handle_ImmediateLambda,
+			&&handle_ImmediateMacro,
+			&&handle_ImmediateClosure,
+			&&handle_default,
+			&&handle_default
+		};
+#endif /* THREADED_DISPATCH */
+
+		REDUCE_DISPATCH(operation_reduce_mode) {
+			DISPATCH_CASE(SpecialQuote)
+				// Special: does not evaluate
+				vm_push_operation(OP_VM_QUOTE, input, environment, VMState::Quote{});
+				return true;
+
+			DISPATCH_CASE(SpecialCond)
+				// Special:
+				vm_push_operation(OP_VM_COND, make_cdr(input), environment, VMState::Cond{false});
+				return true;
+
+			DISPATCH_CASE(Normal0)
+			DISPATCH_CASE(Normal1)
+			DISPATCH_CASE(Normal2)
+			DISPATCH_CASE(Normal3)
+				// Normal:
+				vm_push_operation(OP_VM_NORMAL, input, environment, VMState::Normal{(unsigned int) (operation_reduce_mode - Normal0)});
+				return true;
+
+			DISPATCH_CASE(SpecialLoad)
+				// Special:
+				vm_push_operation(OP_VM_LOAD, input, environment, VMState::Load{operation_index, false});
+				return true;
+
+			DISPATCH_CASE(SpecialLogic)
+				// Special:
+				vm_push_operation(OP_VM_LOGIC, make_cdr(input), environment, VMState::Logic{operation_index, false});
+				return true;
+
+			DISPATCH_CASE(SpecialBegin)
+				// Special:
+				vm_push_operation(OP_VM_BEGIN, make_cdr(input), make_environment(environment), VMState::Begin{false, nullptr});
+				return true;
+
+			DISPATCH_CASE(SpecialDefine)
+				// Special:
+				vm_push_operation(OP_VM_DEFINE, input, environment, VMState::Define{operation_index, false});
+				return true;
+
+			DISPATCH_CASE(SpecialIf)
+				// Special:
+				vm_push_operation(OP_VM_IF, make_cdr(input), environment, VMState::If{false});
+				return true;
+
+			DISPATCH_CASE(SpecialLet)
+				// Special:
+				vm_push_operation(OP_VM_LET, input, environment, VMState::Let{operation_index, false, nullptr});
+				return true;
+
+			DISPATCH_CASE(ImmediateLambda)
+				data_push(eval_lambda(input, environment));
+				return true;
+
+			DISPATCH_CASE(ImmediateMacro)
+				data_push(eval_macro(input, environment));
+				return true;
+
+			DISPATCH_CASE(ImmediateClosure)
+				data_push(eval_closure(input, environment));
+				return true;
+
+			DISPATCH_CASE(NormalX)
+				// Normal:
+				vm_push_operation(OP_VM_NORMAL, input, environment, VMState::Normal{count_members(input) - 1});
+				return true;
+			
+			DISPATCH_DEFAULT
+				print_integral(operation_reduce_mode);
+				print_error(" at eval_reduce()", "unknown reduce requested\n");
+				vm_finish();
+		}
+	}
+
+	// Here, the operator is itself a list
+	// 		1) If it has been evaluated, it should be a closure or a macro
+	//		2) If it has not been evaluated, we create a new ("vm-first" ...)
+
+	bool is_closure = first->is_operation(OP_CLOSURE);
+	bool is_macro = first->is_operation(OP_MACRO);
+
+	if(is_closure || is_macro) {
+		vm_push_operation(OP_VM_APPLY, input, environment, VMState::Apply{is_closure, false, count_members(input) - 1});
+		return true;
+	}
+
+	if((first->is_atom() && (first->is_pure() || first->is_local())) || first->is_list()) {
+		vm_push_operation(OP_VM_FIRST, input, environment, VMState::First{false});
+		return true;
+	}
+
+	print_error(input, "unknown form\n");
+
+	return false;
+}
+
+#ifdef BYTECODE
+inline bool is_compiled(const LispNodeRC &closure) {
+	const LispNodeRC &lambda = closure->head->next->next->item;
+
+	return lambda->head->next->next->item->is_code();
+}
+
+bool vm_push_code(const LispNodeRC &closure, unsigned int arity) {
+	const LispNodeRC &lambda = closure->head->next->next->item;
+	const LispNodeRC &code_atom = lambda->head->next->next->item;
+
+	Bytecode *code = code_atom->code;
+
+	// The arguments are the top <arity> entries of the data stack
+	unsigned int base = data_top - arity;
+
+	if(code->packed_dot) {
+		if(arity < code->number_parameters) {
+			print_error("operator application", "missing or extra arguments\n");
+
+			return false;
+		}
+
+		LispNodeRC packed_arguments = list_empty;
+
+		while(data_top > base + code->number_parameters - 1) {
+			packed_arguments = make_cons(data_peek(), packed_arguments);
+			data_pop();
+		}
+
+		data_push(packed_arguments);
+	}
+	else if(arity != code->number_parameters) {
+		print_error("operator application", "missing or extra arguments\n");
+
+		return false;
+	}
+
+	if(!data_reserve(base + code->maximum_stack)) {
+		fputs("Data stack overflow; use tail-recursion\n", stdout);
+
+		return false;
+	}
+
+	const LispNodeRC &closure_name = closure->head->next->item;
+
+	LispNodeRC environment = make_environment(closure->head->next->next->next->item);
+
+	// Same binding as in make_lambda_macro_application()
+	if(closure_name != list_empty && closure_name->symbol->value.get_pointer() != closure.get_pointer() && make_query_optional_replace(closure_name, environment) == nullptr) {
+		environment = make_cons(make2(closure_name, closure), environment);
+	}
+
+	if(code->environment_mode) {
+		unsigned int slot = base;
+
+		for(Box *current_parameter_box = code->parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+			if(current_parameter_box->item != symbol_dot) {
+				environment = make_cons(make2(current_parameter_box->item, data_stack[slot]), environment);
+				slot++;
+			}
+		}
+
+		data_top = base;
+	}
+
+	vm_push_operation(OP_VM_CODE, closure, environment, VMState::Code{0, base});
+	vm_peek().extra1 = code_atom;
+
+	return true;
+}
+
+LispNodeRC vm_code_environment(const VMStackFrame &frame, const Bytecode *code, const LispNodeRC &let_scope) {
+	if(code->environment_mode) {
+		return frame.environment;
+	}
+
+	// Builds the environment the tree-walking VM would have used for the same body
+	LispNodeRC environment = frame.environment;
+
+	unsigned int slot = frame.vm_state.code.base;
+
+	for(Box *current_parameter_box = code->parameters->get_head_pointer(); current_parameter_box != nullptr; current_parameter_box = current_parameter_box->get_next_pointer()) {
+		if(current_parameter_box->item != symbol_dot) {
+			environment = make_cons(make2(current_parameter_box->item, data_stack[slot]), environment);
+			slot++;
+		}
+	}
+
+	for(Box *current_binding_box = let_scope->get_head_pointer(); current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+		environment = make_cons(make2(current_binding_box->item->head->item, data_stack[frame.vm_state.code.base + current_binding_box->item->head->next->item->number_i]), environment);
+	}
+
+	return environment;
+}
+
+void vm_step_code() {
+	VMStackFrame &top = vm_peek();
+
+	Bytecode *code = top.extra1->code;
+
+	const uint16_t *instructions = code->instructions;
+	const LispNodeRC *constants = code->constants;
+
+	unsigned int ip = top.vm_state.code.ip;
+	unsigned int base = top.vm_state.code.base;
+
+	// Runs until the frame returns or calls a closure (the VM resumes it afterwards)
+	while(true) {
+		switch(instructions[ip]) {
+			case BC_CONSTANT:
+				data_push(constants[instructions[ip + 1]]);
+
+				ip += 2;
+				break;
+			case BC_LOCAL:
+				data_push(data_stack[base + instructions[ip + 1]]);
+
+				ip += 2;
+				break;
+			case BC_ENVIRONMENT:
+			case BC_LOOKUP: {
+				const LispNodeRC &reference = constants[instructions[ip + 1]];
+
+				LispNodeRC value = (instructions[ip] == BC_ENVIRONMENT ? eval_local(reference, top.environment) : lookup_symbol(reference, top.environment));
+
+				if(value == nullptr) {
+					print_error(reference, "evaluation error\n");
+					vm_finish();
+
+					return;
+				}
+
+				data_push(value);
+
+				ip += 2;
+				break;
+			}
+			case BC_SET_LOCAL: {
+				const LispNodeRC &symbol = constants[instructions[ip + 2]];
+				LispNodeRC &value = data_peek();
+
+				if(value->is_operation(OP_CLOSURE)) {
+					value->head->next->item = symbol;
+				}
+
+				data_stack[base + instructions[ip + 1]] = value;
+				value = list_empty;
+
+				ip += 3;
+				break;
+			}
+			case BC_SET: {
+				const LispNodeRC &symbol = constants[instructions[ip + 1]];
+				LispNodeRC &value = data_peek();
+
+				if(value->is_operation(OP_CLOSURE)) {
+					value->head->next->item = symbol;
+				}
+
+				if(make_query_optional_replace(symbol, top.environment, value) == nullptr && symbol->symbol->value != nullptr) {
+					symbol->symbol->value = value;
+				}
+
+				value = list_empty;
+
+				ip += 2;
+				break;
+			}
+			case BC_POP:
+				data_pop();
+
+				ip += 1;
+				break;
+			case BC_SLIDE: {
+				unsigned int count = instructions[ip + 1];
+
+				data_stack[data_top - 1 - count] = data_peek();
+				data_top -= count;
+
+				ip += 2;
+				break;
+			}
+			case BC_JUMP:
+				ip = instructions[ip + 1];
+				break;
+			case BC_JUMP_UNLESS_TRUE: {
+				bool is_true = (data_peek().get_pointer() == atom_true.get_pointer());
+				data_pop();
+
+				ip = (is_true ? ip + 2 : instructions[ip + 1]);
+				break;
+			}
+			case BC_AND:
+			case BC_OR: {
+				const LispNodeRC &decisive_value = (instructions[ip] == BC_AND ? atom_false : atom_true);
+
+				if(data_peek().get_pointer() == decisive_value.get_pointer()) {
+					ip = instructions[ip + 1];
+				}
+				else {
+					data_pop();
+
+					ip += 2;
+				}
+
+				break;
+			}
+			case BC_CLOSURE:
+				data_push(make4(make_operator(OP_CLOSURE), list_empty, constants[instructions[ip + 1]], top.environment));
+
+				ip += 2;
+				break;
+			case BC_OPERATOR: {
+				unsigned int arity = instructions[ip + 2];
+
+				LispNodeRC result = vm_call_operator(instructions[ip + 1], arity, top.environment);
+
+				if(result == nullptr) {
+					print_error(constants[instructions[ip + 3]], "evaluation error\n");
+					vm_finish();
+
+					return;
+				}
+
+				for(unsigned int i = 0; i < arity; i++) {
+					data_pop();
+				}
+
+				data_push(result);
 
-		struct Call {
-			unsigned int arity;
+				ip += 4;
+				break;
+			}
+			case BC_CHECK_CALLEE: {
+				const LispNodeRC &callee = data_peek();
 
-			Call(unsigned int arity): arity{arity} {}
-		} call;
+				bool is_procedure = callee->is_operation(OP_CLOSURE);
 
-		struct EvalList {
-			bool discard_intermediary;
-			bool waiting;
+				if(callee->is_operator() && callee->number_i >= 0) {
+					is_procedure = is_native_procedure(callee->number_i);
+				}
 
-			EvalList(bool discard_intermediary, bool waiting): discard_intermediary{discard_intermediary}, waiting{waiting} {}
-		} eval_list;
+				if(!is_procedure) {
+					// Macros take the arguments unevaluated, so the whole expression goes to the tree-walking VM
+					data_pop();
 
-		State(): apply{false, false, 0} {}
+					top.vm_state.code.ip = instructions[ip + 2];
+					vm_push_operation(OP_VM_EVAL, constants[instructions[ip + 1]], vm_code_environment(top, code, constants[instructions[ip + 3]]), VMState::Eval{});
 
-		~State() {
-		}
+					return;
+				}
 
-		State(const Apply &apply): apply{apply} {}
-		State(const First &first): first{first} {}
-		State(const Normal &normal): normal{normal} {}
-		State(const Quote &quote): quote{quote} {}
-		State(const Cond &cond): cond{cond} {}
-		State(const Logic &logic): logic{logic} {}
-		State(const Define &define): define{define} {}
-		State(const Begin &begin): begin{begin} {}
-		State(const Eval &eval): eval{eval} {}
-		State(const Load &load): load{load} {}
-		State(const Call &call): call{call} {}
-		State(const EvalList &eval_list): eval_list{eval_list} {}
-	} vm_state;
+				ip += 4;
+				break;
+			}
+			case BC_CALL:
+			case BC_TAIL_CALL: {
+				bool is_tail = (instructions[ip] == BC_TAIL_CALL);
 
-	VMStackFrame(): op(0), input(nullptr), environment(nullptr), vm_state{State(State::Eval())} {}
-	VMStackFrame(int op, const LispNodeRC &input, const LispNodeRC &environment, const State &vm_state): op(op), input(input), environment(environment), vm_state{vm_state} {}
+				unsigned int arity = instructions[ip + 1];
+				unsigned int first_argument = data_top - arity;
 
-	~VMStackFrame() {}
-};
+				LispNodeRC callee = data_stack[first_argument - 1];
 
-using VMState = VMStackFrame::State;
+				if(callee->is_operator()) {
+					ReduceMode callee_reduce_mode = operator_reduce_modes[callee->number_i];
 
-constexpr int EVALUATION_STACK_SIZE = 128;
-constexpr int DATA_STACK_SIZE = 128;
+					if(callee_reduce_mode != NormalX && arity != (unsigned int) (callee_reduce_mode - Normal0)) {
+						print_error(constants[instructions[ip + 2]], "missing or extra arguments\n");
+						vm_finish();
 
-VMStackFrame *evaluation_stack;
-LispNodeRC *data_stack;
+						return;
+					}
 
-unsigned int vm_top;
-unsigned int data_top;
+					LispNodeRC result = vm_call_operator(callee->number_i, arity, top.environment);
 
-unsigned int vm_maximum;
-unsigned int data_maximum;
+					if(result == nullptr) {
+						print_error(constants[instructions[ip + 2]], "evaluation error\n");
+						vm_finish();
 
-void vm_push_operation(int op, const LispNodeRC &input, const LispNodeRC &environment, const VMState &state) {
-	evaluation_stack[vm_top].op = op;
-	evaluation_stack[vm_top].input = input;
-	evaluation_stack[vm_top].environment = environment;
-	evaluation_stack[vm_top].vm_state = state;
+						return;
+					}
 
-	vm_top++;
+					for(unsigned int i = 0; i <= arity; i++) {
+						data_pop();
+					}
 
-	if(vm_top > vm_maximum) {
-		vm_maximum = vm_top;
-	}
-}
+					data_push(result);
 
-inline VMStackFrame &vm_peek() {
-	return evaluation_stack[vm_top - 1];
-}
+					// A tail call is followed by a return
+					ip += 3;
+					break;
+				}
 
-inline void vm_pop() {
-	vm_top--;
-}
+				// The arguments go over the callee or, in a tail call, over this frame
+				unsigned int destination = (is_tail ? base : first_argument - 1);
 
-inline void data_push(const LispNodeRC &node) {
-	data_stack[data_top] = node;
-	data_top++;
+				for(unsigned int i = 0; i < arity; i++) {
+					data_stack[destination + i] = data_stack[first_argument + i];
+				}
 
-	if(data_top > data_maximum) {
-		data_maximum = data_top;
-	}
-}
+				data_top = destination + arity;
 
-inline LispNodeRC &data_peek() {
-	return data_stack[data_top - 1];
-}
+				if(is_tail) {
+					vm_pop();
+				}
+				else {
+					top.vm_state.code.ip = ip + 3;
+				}
 
-inline void data_pop() {
-	data_top--;
-}
+				if(is_compiled(callee)) {
+					if(!vm_push_code(callee, arity)) {
+						vm_finish();
+					}
 
-void vm_finish() {
-	vm_top = 0;
-	data_top = 0;
+					return;
+				}
 
-	context_environment = &global_environment;
-}
+				vm_push_operation(OP_VM_APPLY, make1(callee), global_environment, VMState::Apply{true, true, arity});
 
-void vm_reset() {
-	vm_finish();
+				return;
+			}
+			case BC_RETURN: {
+				LispNodeRC result = data_peek();
 
-	vm_maximum = 0;
-	data_maximum = 0;
-}
+				data_top = base;
+				data_push(result);
 
-bool eval_reduce(const LispNodeRC &input, const LispNodeRC &environment) {
-	if(input->is_atom()) {
-		if(input->is_pure()) {
-			// Try to get an environment definition
+				vm_pop();
 
-			LispNodeRC other_input = make_query_optional_replace(input, environment);
-			
-			if(other_input != nullptr) {
-				data_push(other_input);
-				return true;
+				return;
 			}
+			default:
+				print_integral(instructions[ip]);
+				print_error(" at vm_step_code()", "unknown instruction\n");
+				vm_finish();
 
-			print_error(input, "evaluation error\n");
-			return false;
+				return;
 		}
-
-		data_push(input);
-		return true;
 	}
+}
+#endif /* BYTECODE */
+
+bool vm_run() {
+#ifdef THREADED_DISPATCH
+	// Indexed by the operation minus OP_VM_FIRST
+	static const void *vm_handlers[] = {
+		&&handle_OP_VM_FIRST,
+		&&handle_OP_VM_NORMAL,
+		&&handle_OP_VM_QUOTE,
+		&&handle_OP_VM_COND,
+		&&handle_OP_VM_LOGIC,
+		&&handle_OP_VM_DEFINE,
+		&&handle_OP_VM_BEGIN,
+		&&handle_OP_VM_APPLY,
+		&&handle_OP_VM_EVAL,
+		&&handle_OP_VM_LOAD,
+		&&handle_OP_VM_CALL,
+		&&handle_OP_VM_EVAL_LIST,
+		&&handle_OP_VM_IF,
+		&&handle_OP_VM_LET,
+#ifdef BYTECODE
+		&&handle_OP_VM_CODE
+#else
+		&&handle_default
+#endif /* BYTECODE */
+	};
+#endif /* THREADED_DISPATCH */
 
-	// Input is a list...
+	VMStackFrame *top;
 
-	if(input->head == nullptr) {
-		print_error("\'()", "evaluation error\n");
-		return false;
-	}
+	// Pointer, because we typically modify state
+	VMState *vm_state;
 
-	const LispNodeRC &first = input->head->item;
+	LispNodeRC input;
+	LispNodeRC environment;
 
-	if(first->is_operator()) {
-		// First try one of the predefined operators
-		int operation_index = first->number_i;
-		ReduceMode operation_reduce_mode = operation_index >= 0 ? operator_reduce_modes[first->number_i] : Unspecified;
+	while(true) {
+		VM_DISPATCH() {
+			// (vm-first <waiting> (input environment))
+			DISPATCH_CASE(OP_VM_FIRST) {
+				bool &waiting = vm_state->first.waiting;
+
+				if(waiting == false) {
+					vm_push_operation(OP_VM_EVAL, input->head->item, environment, VMState::Eval{});
+					waiting = true;
+				}
+				else {
+					LispNodeRC result = data_peek();
 
-		switch(operation_reduce_mode) {
-			case SpecialQuote:
-				// Special: does not evaluate
-				vm_push_operation(OP_VM_QUOTE, input, environment, VMState::Quote{});
-				return true;
+					if(result != input->head->item) {
+						// Data used as code (such as a quoted lambda) is copied, as lambdas are resolved in place
+						if(result->is_list() && !result->is_operation(OP_CLOSURE) && !result->is_operation(OP_MACRO)) {
+							result = make_copy(result);
+						}
 
-			case SpecialCond:
-				// Special:
-				vm_push_operation(OP_VM_COND, make_cdr(input), environment, VMState::Cond{false});
-				return true;
+						vm_pop();
+						vm_push_operation(OP_VM_EVAL, make_cons(result, make_cdr(input)), environment, VMState::Eval{});
+					}
+					else {
+						vm_pop();
+						vm_push_operation(OP_VM_EVAL, input, environment, VMState::Eval{});
+					}
 
-			case Normal0:
-			case Normal1:
-			case Normal2:
-			case Normal3:
-				// Normal:
-				vm_push_operation(OP_VM_NORMAL, input, environment, VMState::Normal{(unsigned int) (operation_reduce_mode - Normal0)});
-				return true;
+					data_pop();
+				}
 
-			case SpecialLoad:
-				// Special:
-				vm_push_operation(OP_VM_LOAD, input, environment, VMState::Load{operation_index, false});
-				return true;
+				VM_NEXT();
+			}
+			// (vm-normal <arity> (input environment))
+			DISPATCH_CASE(OP_VM_NORMAL) {
+				unsigned int arity = vm_state->normal.arity;
 
-			case SpecialLogic:
-				// Special:
-				vm_push_operation(OP_VM_LOGIC, make_cdr(input), environment, VMState::Logic{operation_index, false});
-				return true;
+				if(count_members(input) != arity + 1) {
+					print_error(input, "missing or extra arguments\n");
+					vm_finish();
 
-			case SpecialBegin:
-				// Special:
-				vm_push_operation(OP_VM_BEGIN, make_cdr(input), make_environment(environment), VMState::Begin{false, nullptr});
-				return true;
+					VM_NEXT();
+				}
 
-			case SpecialDefine:
-				// Special:
-				vm_push_operation(OP_VM_DEFINE, input, environment, VMState::Define{operation_index, false});
-				return true;
+				vm_pop();
 
-			case SpecialEval:
-				vm_push_operation(OP_VM_EVAL, input, environment, VMState::Eval{});
-				return true;
+				vm_push_operation(OP_VM_CALL, input, environment, VMState::Call{arity});
+				vm_push_operation(OP_VM_EVAL_LIST, make_cdr(input), environment, VMState::EvalList{false, false});
 
-			case ImmediateLambda:
-				data_push(eval_lambda(input, environment));
-				return true;
+				VM_NEXT();
+			}
+			// (vm-quote () (input environment))
+			DISPATCH_CASE(OP_VM_QUOTE) {
+				if(count_members(input) != 2) {
+					print_error(input, "missing or extra arguments\n");
+					vm_finish();
 
-			case ImmediateMacro:
-				data_push(eval_macro(input, environment));
-				return true;
+					VM_NEXT();
+				}
 
-			case ImmediateClosure:
-				data_push(eval_closure(input, environment));
-				return true;
+				const LispNodeRC &quoted_expression = input->head->next->item;
 
-			case NormalX:
-				// Normal:
-				vm_push_operation(OP_VM_NORMAL, input, environment, VMState::Normal{count_members(input) - 1});
-				return true;
-			
-			default:
-				print_integral(operation_reduce_mode);
-				print_error(" at eval_reduce()", "unknown reduce requested\n");
-				vm_finish();
-		}
-	}
+				vm_pop();
+				data_push(quoted_expression);
 
-	// Here, the operator is itself a list
-	// 		1) If it has been evaluated, it should be a closure or a macro
-	//		2) If it has not been evaluated, we create a new ("vm-first" ...)
+				VM_NEXT();
+			}
+			// (vm-cond <waiting> ([(t1 c1) ... (tN cN)] environment))
+			DISPATCH_CASE(OP_VM_COND) {
+				LispNodeRC &evaluation_pairs = top->input;
 
-	bool is_closure = first->is_operation(OP_CLOSURE);
-	bool is_macro = first->is_operation(OP_MACRO);
+				bool &waiting = vm_state->cond.waiting;
 
-	if(is_closure || is_macro) {
-		vm_push_operation(OP_VM_APPLY, input, environment, VMState::Apply{is_closure, false, count_members(input) - 1});
-		return true;
-	}
+				if(waiting == false && evaluation_pairs == list_empty) {
+					vm_pop();
+					data_push(list_empty);
 
-	if((first->is_atom() && first->is_pure()) || first->is_list()) {
-		vm_push_operation(OP_VM_FIRST, input, environment, VMState::First{false});
-		return true;
-	}
+					VM_NEXT();
+				}
 
-	print_error(input, "unknown form\n");
+				const LispNodeRC &current_pair = evaluation_pairs->head->item;
+				const LispNodeRC &current_test = current_pair->head->item;
 
-	return false;
-}
+				if(waiting == false) {
+					vm_push_operation(OP_VM_EVAL, current_test, environment, VMState::Eval{});
+					waiting = true;
+				}
+				else {
+					LispNodeRC result = data_peek();
+					data_pop();
 
-void vm_step() {
-	VMStackFrame &top = vm_peek();
+					if(result == atom_true) {
+						if(current_pair->get_head_pointer()->get_next_pointer() == nullptr) {
+							// No consequent: just evaluate to the empty list
 
-	// Reference, because we typically modify state
-	VMState &vm_state = top.vm_state;
+							vm_pop();
+							data_push(list_empty);
 
-	LispNodeRC input = top.input;
-	LispNodeRC environment = top.environment;
+							VM_NEXT();
+						}
 
-	int operation_index = top.op;
+						if(current_pair->get_head_pointer()->get_next_pointer()->get_next_pointer() == nullptr) {
+							LispNodeRC current_consequent = current_pair->head->next->item;
 
-	switch(operation_index) {
-		// (vm-first <waiting> (input environment))
-		case OP_VM_FIRST: {
-			bool &waiting = vm_state.first.waiting;
+							vm_pop();
+							vm_push_operation(OP_VM_EVAL, current_consequent, environment, VMState::Eval{});
+						}
+						else {
+							// The consequent is a sequence of operations
+							LispNodeRC current_consequent = LispNode::make_list(current_pair->get_head_pointer()->get_next_pointer());
 
-			if(waiting == false) {
-				vm_push_operation(OP_VM_EVAL, input->head->item, environment, VMState::Eval{});
-				waiting = true;
-			}
-			else {
-				const LispNodeRC &result = data_peek();
+							vm_pop();
+							vm_push_operation(OP_VM_BEGIN, current_consequent, environment, VMState::Begin{false, nullptr});
+						}
 
-				if(result != input->head->item) {
-					vm_pop();
-					vm_push_operation(OP_VM_EVAL, make_cons(result, make_cdr(input)), environment, VMState::Eval{});
-				}
-				else {
-					vm_pop();
-					vm_push_operation(OP_VM_EVAL, input, environment, VMState::Eval{});
+						VM_NEXT();
+					}
+
+					evaluation_pairs = make_cdr(evaluation_pairs);
+					waiting = false;
 				}
 
-				data_pop();
+				VM_NEXT();
 			}
+			// (vm-logic (<OP_AND/OP_OR> <waiting>) (evaluation_items environment))
+			DISPATCH_CASE(OP_VM_LOGIC) {
+				LispNodeRC &evaluation_items = top->input;
 
-			return;
-		}
-		// (vm-normal <arity> (input environment))
-		case OP_VM_NORMAL: {
-			unsigned int arity = vm_state.normal.arity;
-
-			if(count_members(input) != arity + 1) {
-				print_error(input, "missing or extra arguments\n");
-				vm_finish();
+				int type = vm_state->logic.type;
+				bool &waiting = vm_state->logic.waiting;
 
-				return;
-			}
+				if(evaluation_items == list_empty) {
+					vm_pop();
 
-			vm_pop();
+					if(type == OP_AND) {
+						data_push(atom_true);
+					}
 
-			vm_push_operation(OP_VM_CALL, input, environment, VMState::Call{arity});
-			vm_push_operation(OP_VM_EVAL_LIST, make_cdr(input), environment, VMState::EvalList{false, false});
+					if(type == OP_OR) {
+						data_push(atom_false);
+					}
 
-			return;
-		}
-		// (vm-quote () (input environment))
-		case OP_VM_QUOTE: {
-			if(count_members(input) != 2) {
-				print_error(input, "missing or extra arguments\n");
-				vm_finish();
+					VM_NEXT();
+				}
 
-				return;
-			}
+				if(waiting == true) {
+					LispNodeRC result = data_peek();
+					data_pop();
 
-			const LispNodeRC &quoted_expression = input->head->next->item;
+					if(type == OP_AND && result == atom_false) {
+						vm_pop();
+						data_push(atom_false);
 
-			vm_pop();
-			data_push(quoted_expression);
+						VM_NEXT();
+					}
+					if(type == OP_OR && result == atom_true) {
+						vm_pop();
+						data_push(atom_true);
 
-			return;
-		}
-		// (vm-cond <waiting> ([(t1 c1) ... (tN cN)] environment))
-		case OP_VM_COND: {
-			LispNodeRC &evaluation_pairs = top.input;
+						VM_NEXT();
+					}
 
-			bool &waiting = vm_state.cond.waiting;
+					evaluation_items = make_cdr(evaluation_items);
+				}
 
-			if(waiting == false && evaluation_pairs == list_empty) {
-				vm_pop();
-				data_push(list_empty);
+				bool last_item = (evaluation_items->head->next == nullptr);
 
-				return;
-			}
+				// For tail-recursion (the value of the last item is the value of the operation)
+				if(last_item) {
+					vm_pop();
+					vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
 
-			const LispNodeRC &current_pair = evaluation_pairs->head->item;
-			const LispNodeRC &current_test = current_pair->head->item;
+					VM_NEXT();
+				}
 
-			if(waiting == false) {
-				vm_push_operation(OP_VM_EVAL, current_test, environment, VMState::Eval{});
+				vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
 				waiting = true;
-			}
-			else {
-				LispNodeRC result = data_peek();
-				data_pop();
 
-				if(result == atom_true) {
-					if(current_pair->get_head_pointer()->get_next_pointer() == nullptr) {
-						// No consequent: just evaluate to the empty list
+				VM_NEXT();
+			}
+			// (vm-define (<OP_DEFINE/OP_SET_E> <waiting>) (input environment))
+			DISPATCH_CASE(OP_VM_DEFINE) {
+				int type = vm_state->define.type;
+				bool &waiting = vm_state->define.waiting;
 
-						vm_pop();
-						data_push(list_empty);
+				const LispNodeRC &operation = input->head->item;
+				const LispNodeRC &argument1 = input->head->next->item;
+				const LispNodeRC &argument2 = input->head->next->next->item;
 
-						return;
+				bool is_define_lambda = argument1->is_list();
+
+				LispNodeRC symbol = is_define_lambda ? argument1->head->item : input->head->next->item;
+
+				if(waiting == false) {
+					if(count_members(input) < 3) {
+						print_error(input, "missing arguments\n");
+						vm_finish();
+
+						VM_NEXT();
 					}
 
-					if(current_pair->get_head_pointer()->get_next_pointer()->get_next_pointer() == nullptr) {
-						LispNodeRC current_consequent = current_pair->head->next->item;
+					if(!symbol->is_atom() || !symbol->is_pure()) {
+						print_error(symbol, "argument type error\n");
+						vm_finish();
 
-						vm_pop();
-						vm_push_operation(OP_VM_EVAL, current_consequent, environment, VMState::Eval{});
+						VM_NEXT();
 					}
-					else {
-						// The consequent is a sequence of operations
-						LispNodeRC current_consequent = LispNode::make_list(current_pair->get_head_pointer()->get_next_pointer());
 
-						vm_pop();
-						vm_push_operation(OP_VM_BEGIN, current_consequent, environment, VMState::Begin{false, nullptr});
+					LispNodeRC expression = argument2;
+
+					if(is_define_lambda) {
+						LispNodeRC lambda_parameters = make_cdr(argument1);
+						LispNodeRC lambda_expression = LispNode::make_list(input->get_head_pointer()->get_next_pointer()->get_next_pointer());
+
+						expression = make_cons(make_operator(OP_LAMBDA), make_cons(lambda_parameters, lambda_expression));
 					}
 
-					return;
+					// Evaluate using the current (unextended) environment
+					vm_push_operation(OP_VM_EVAL, expression, environment, VMState::Eval{});
+
+					waiting = true;
 				}
+				else {
+					const LispNodeRC &evaluated_expression = data_peek();
 
-				evaluation_pairs = make_cdr(evaluation_pairs);
-				waiting = false;
-			}
+					if(evaluated_expression->is_operation(OP_CLOSURE)) {
+						evaluated_expression->head->next->item = symbol;
+					}
 
-			return;
-		}
-		// (vm-logic (<OP_AND/OP_OR> <waiting>) (evaluation_items environment))
-		case OP_VM_LOGIC: {
-			LispNodeRC &evaluation_items = top.input;
+					bool is_global = (context_environment == &global_environment);
 
-			int type = vm_state.logic.type;
-			bool &waiting = vm_state.logic.waiting;
+					if(type == OP_DEFINE && !is_global) {
+						*context_environment = make_cons(make2(symbol, list_empty), environment);
+					}
 
-			if(evaluation_items == list_empty) {
-				vm_pop();
+					// Names not bound locally are (re)bound in place in the global value cell
+					if(make_query_optional_replace(symbol, *context_environment, evaluated_expression) == nullptr) {
+						if(type == OP_DEFINE || symbol->symbol->value != nullptr) {
+							symbol->symbol->value = evaluated_expression;
+						}
+					}
 
-				if(type == OP_AND) {
-					data_push(atom_true);
-				}
+					data_pop();
 
-				if(type == OP_OR) {
-					data_push(atom_false);
+					vm_pop();
+					data_push(list_empty);
 				}
 
-				return;
+				VM_NEXT();
 			}
+			// (vm-begin (<saved_context_environment> <waiting>) (evaluation_items environment))
+			DISPATCH_CASE(OP_VM_BEGIN) {
+				bool &waiting = vm_state->begin.waiting;
+				LispNodeRC *&saved_context_environment = vm_state->begin.saved_context_environment;
 
-			if(waiting == false) {
-				vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
-				waiting = true;
+				if(waiting == false) {
+					if(input == list_empty) {
+						vm_pop();
+						data_push(list_empty);
 
-				return;
-			}
+						VM_NEXT();
+					}
 
-			LispNodeRC result = data_peek();
-			data_pop();
+					saved_context_environment = context_environment;
 
-			if(type == OP_AND && result == atom_false) {
-				vm_pop();
-				data_push(atom_false);
+					vm_push_operation(OP_VM_EVAL_LIST, input, environment, VMState::EvalList{true, false});
+					context_environment = &(vm_peek().environment);
 
-				return;
-			}
-			if(type == OP_OR && result == atom_true) {
-				vm_pop();
-				data_push(atom_true);
+					waiting = true;
+				}
+				else {
+					context_environment = saved_context_environment;
 
-				return;
+					vm_pop();
+				}
+
+				VM_NEXT();
 			}
+			// (vm-apply (<arity> <closure_mode> <waiting>) (input environment))
+			DISPATCH_CASE(OP_VM_APPLY) {
+				unsigned int arity = vm_state->apply.arity;
+				bool closure_mode = vm_state->apply.closure_mode;
+				bool &waiting = vm_state->apply.waiting;
+
+				if(waiting == false && closure_mode == true) {
+					vm_push_operation(OP_VM_EVAL_LIST, make_cdr(input), environment, VMState::EvalList{false, false});
+					waiting = true;
+				}
+				else {
+#ifdef BYTECODE
+					// Compiled closures take their arguments directly from the data stack
+					if(closure_mode == true && is_compiled(input->head->item)) {
+						LispNodeRC closure = input->head->item;
+
+						vm_pop();
+						vm_complete_begins();
 
-			bool last_item = (evaluation_items->head->next == nullptr);
+						if(!vm_push_code(closure, arity)) {
+							vm_finish();
+						}
 
-			// For tail-recursion
-			if(last_item) {
-				vm_pop();
-			}
+						VM_NEXT();
+					}
+#endif /* BYTECODE */
 
-			vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
+					LispNodeRC evaluated_input = list_empty;
 
-			if(last_item) {
-				return;
-			}
+					if(closure_mode == true) {
+						for(unsigned int i = 0; i < arity; i++) {
+							evaluated_input = make_cons(data_peek(), evaluated_input);
+							data_pop();
+						}
 
-			evaluation_items = make_cdr(evaluation_items);
-			waiting = false;
+						// Add the original operator to the front of the evaluated arguments
+						evaluated_input = make_cons(input->head->item, evaluated_input);
+					}
 
-			return;
-		}
-		// (vm-define (<OP_DEFINE/OP_SET_E> <waiting>) (input environment))
-		case OP_VM_DEFINE: {
-			int type = vm_state.define.type;
-			bool &waiting = vm_state.define.waiting;
+					LispNodeRC lambda_application = make_lambda_macro_application(closure_mode ? evaluated_input : input, environment);
 
-			const LispNodeRC &operation = input->head->item;
-			const LispNodeRC &argument1 = input->head->next->item;
-			const LispNodeRC &argument2 = input->head->next->next->item;
+					if(lambda_application == nullptr) {
+						// Error message printed in the make_lambda_macro_application() function
+						vm_finish();
+						VM_NEXT();
+					}
 
-			bool is_define_lambda = argument1->is_list();
+					const LispNodeRC &new_expression = lambda_application->head->item;
+					const LispNodeRC &new_environment = lambda_application->head->next->item;
 
-			LispNodeRC symbol = is_define_lambda ? argument1->head->item : input->head->next->item;
+					vm_pop();
 
-			if(waiting == false) {
-				if(count_members(input) < 3) {
-					print_error(input, "missing arguments\n");
-					vm_finish();
+					// For tail calls (the new begin goes on the same stack level as the completed ones)
+					if(closure_mode == true) {
+						vm_complete_begins();
+					}
 
-					return;
+					vm_push_operation(OP_VM_BEGIN, new_expression, new_environment, VMState::Begin{false, nullptr});
 				}
 
-				if(!symbol->is_atom() || !symbol->is_pure()) {
-					print_error(symbol, "argument type error\n");
-					vm_finish();
+				VM_NEXT();
+			}
+			// (vm-eval '() (input environment))
+			DISPATCH_CASE(OP_VM_EVAL) {
+				vm_pop();
 
-					return;
+				if(!eval_reduce(input, environment)) {
+					vm_finish();
 				}
 
-				LispNodeRC expression = argument2;
+				VM_NEXT();
+			}
+			// (vm-load (<type>, <waiting>) (input environment))
+			DISPATCH_CASE(OP_VM_LOAD) {
+#ifdef INITIAL_ENVIRONMENT
+				int type = vm_state->load.type;
+				bool &waiting = vm_state->load.waiting;
 
-				if(is_define_lambda) {
-					LispNodeRC lambda_parameters = make_cdr(argument1);
-					LispNodeRC lambda_expression = LispNode::make_list(input->get_head_pointer()->get_next_pointer()->get_next_pointer());
+				if(waiting == false) {
+					if(count_members(input) != 2) {
+						print_error(input, "missing or extra arguments\n");
+						vm_finish();
 
-					expression = make_cons(make_operator(OP_LAMBDA), make_cons(lambda_parameters, lambda_expression));
-				}
+						VM_NEXT();
+					}
 
-				// Evaluate using the current (unextended) environment
-				vm_push_operation(OP_VM_EVAL, expression, environment, VMState::Eval{});
+					const LispNodeRC &symbol = input->head->next->item;
 
-				waiting = true;
-			}
-			else {
-				const LispNodeRC &evaluated_expression = data_peek();
+					vm_push_operation(OP_VM_EVAL, symbol, environment, VMState::Eval{});
 
-				if(evaluated_expression->is_operation(OP_CLOSURE)) {
-					evaluated_expression->head->next->item = symbol;
+					waiting = true;
 				}
+				else {
+					LispNodeRC evaluated_symbol = data_peek();
+					data_pop();
 
-				if(type == OP_DEFINE) {
-					*context_environment = make_cons(make2(symbol, list_empty), environment);;
-				}
+					// Built-in forms such as 'if evaluate to operators, not symbols
+					if(!evaluated_symbol->is_atom() || !evaluated_symbol->is_pure()) {
+						print_error(input, "argument type error\n");
+						vm_finish();
 
-				make_query_optional_replace(symbol, *context_environment, evaluated_expression);
+						VM_NEXT();
+					}
 
-				data_pop();
+					if(type == OP_LOAD) {
+						int index;
+						const char *value = nullptr;
 
-				vm_pop();
-				data_push(list_empty);
-			}
+						if((index = get_lambda_index(evaluated_symbol->symbol->name)) != -1) {
+							value = lambda_strings[index];
+						}
 
-			return;
-		}
-		// (vm-begin (<saved_context_environment> <current_closure> <waiting>) (evaluation_items environment))
-		case OP_VM_BEGIN: {
-			bool &waiting = vm_state.begin.waiting;
-			LispNodeRC *&saved_context_environment = vm_state.begin.saved_context_environment;
+						if((index = get_macro_index(evaluated_symbol->symbol->name)) != -1) {
+							value = macro_strings[index];
+						}
 
-			if(waiting == false) {
-				if(input == list_empty) {
-					vm_pop();
-					data_push(list_empty);
+						if(value == nullptr) {
+							print_error(input, "unknown form\n");
+							vm_finish();
 
-					return;
-				}
+							VM_NEXT();
+						}
 
-				saved_context_environment = context_environment;
+						LispNodeRC load_expression = make3(make_operator(OP_DEFINE), evaluated_symbol, parse_expression(value, false));
 
-				vm_push_operation(OP_VM_EVAL_LIST, input, environment, VMState::EvalList{true, false});
-				context_environment = &(vm_peek().environment);
+						vm_pop();
+						vm_push_operation(OP_VM_EVAL, load_expression, environment, VMState::Eval{});
+					}
+					else {
+						LispNodeRC unload_expression = make3(make_operator(OP_SET_E), evaluated_symbol, atom_false);
 
-				waiting = true;
-			}
-			else {
-				context_environment = saved_context_environment;
+						vm_pop();
+						vm_push_operation(OP_VM_EVAL, unload_expression, environment, VMState::Eval{});
+					}
+				}
+#else
+				print_error("vm-load", "no compiled support\n");
+				vm_finish();
+#endif /* INITIAL_ENVIRONMENT */
 
-				vm_pop();
+				VM_NEXT();
 			}
+			// (vm-call <arity> (input environment))
+			DISPATCH_CASE(OP_VM_CALL) {
+				unsigned int arity = vm_state->call.arity;
 
-			return;
-		}
-		// (vm-apply (<arity> <closure_mode> <waiting>) (input environment))
-		case OP_VM_APPLY: {
-			unsigned int arity = vm_state.apply.arity;
-			bool closure_mode = vm_state.apply.closure_mode;
-			bool &waiting = vm_state.apply.waiting;
-
-			if(waiting == false && closure_mode == true) {
-				vm_push_operation(OP_VM_EVAL_LIST, make_cdr(input), environment, VMState::EvalList{false, false});
-				waiting = true;
-			}
-			else {
 				LispNodeRC evaluated_input = list_empty;
 
-				if(closure_mode == true) {
-					for(unsigned int i = 0; i < arity; i++) {
-						evaluated_input = make_cons(data_peek(), evaluated_input);
-						data_pop();
-					}
+				bool is_apply = input->is_operation(OP_APPLY);
 
-					// Add the original operator to the front of the evaluated arguments
-					evaluated_input = make_cons(input->head->item, evaluated_input);
-				}
+				if(is_apply) {
+					evaluated_input = data_peek();
+					data_pop();
 
-				bool tail_situation = false;
-				unsigned int tail_begin_blocks_found = 0;
+					if(!evaluated_input->is_list()) {
+						print_error(input, "last argument must be list\n");
+						vm_finish();
 
-				// Check for tail-recursion
-				if(vm_top >= 2) {
-					for(int i = vm_top - 2; i >= 0; i--) {
-						const VMStackFrame &vm_next = evaluation_stack[i];
+						VM_NEXT();
+					}
+				}
 
-						if(vm_next.op == OP_VM_BEGIN) {
-							tail_begin_blocks_found++;
+				// If it is an apply operation, the first input is the operation and it has
+				// already been added
+				if(is_apply) {
+					BoxRC evaluated_parameter_sequence = nullptr;
+					Box *last_box = nullptr;
 
-							const LispNodeRC &current_closure = vm_next.extra1;
+					// The arguments in the list are already evaluated, so they are quoted to stay as they are
+					for(Box *current_box = evaluated_input->get_head_pointer(); current_box != nullptr; current_box = current_box->get_next_pointer()) {
+						Box *quoted_box = new Box(make2(make_operator(OP_QUOTE), current_box->item));
 
-							if(current_closure == input->head->item) {
-								tail_situation = true;
-								break;
-							}
+						if(last_box == nullptr) {
+							evaluated_parameter_sequence = quoted_box;
 						}
 						else {
-							break;
+							last_box->next = quoted_box;
 						}
+
+						last_box = quoted_box;
+					}
+
+					// We already collected one evaluated input
+					for(size_t i = 0; i < arity - 1; i++) {
+						evaluated_parameter_sequence = new Box(data_peek(), evaluated_parameter_sequence);
+						data_pop();
 					}
-				}
 
-				LispNodeRC lambda_application = make_lambda_macro_application(closure_mode ? evaluated_input : input, environment);
+					evaluated_input = LispNode::make_list(evaluated_parameter_sequence.get_pointer());
 
-				if(lambda_application == nullptr) {
-					// Error message printed in the make_lambda_macro_application() function
-					vm_finish();
-					return;
+					vm_pop();
+					vm_push_operation(OP_VM_EVAL, evaluated_input, environment, VMState::Eval{});
+
+					VM_NEXT();
 				}
 
-				const LispNodeRC &new_expression = lambda_application->head->item;
-				const LispNodeRC &new_environment = lambda_application->head->next->item;
+				// The evaluated expression is evaluated again, in the given environment or in this one
+				if(input->is_operation(OP_EVAL)) {
+					if(arity != 1 && arity != 2) {
+						print_error(input, "missing or extra arguments\n");
+						vm_finish();
 
-				vm_pop();
+						VM_NEXT();
+					}
 
-				if(tail_situation) {
-					// Complete the previous begins, then make a new one on the same stack level
+					LispNodeRC eval_environment = environment;
 
-					for(size_t i = 0; i < tail_begin_blocks_found; i++) {
-						VMStackFrame &completed_begin = vm_peek();
+					if(arity == 2) {
+						eval_environment = data_peek();
+						data_pop();
 
-						context_environment = completed_begin.vm_state.begin.saved_context_environment;
+						if(!eval_environment->is_list()) {
+							print_error(input, "argument type error\n");
+							vm_finish();
 
-						vm_pop();
+							VM_NEXT();
+						}
 					}
-				}
 
-				vm_push_operation(OP_VM_BEGIN, new_expression, new_environment, VMState::Begin{false, nullptr});
-				vm_peek().extra1 = closure_mode ? input->head->item.get_pointer() : list_empty;
-			}
+					// Lambdas are resolved in place when evaluated, so the data itself is never evaluated
+					LispNodeRC expression = make_copy(data_peek());
+					data_pop();
 
-			return;
-		}
-		// (vm-eval '() (input environment))
-		case OP_VM_EVAL: {
-			vm_pop();
+					vm_pop();
+					vm_push_operation(OP_VM_EVAL, expression, eval_environment, VMState::Eval{});
 
-			if(!eval_reduce(input, environment)) {
-				vm_finish();
-			}
+					VM_NEXT();
+				}
 
-			return;
-		}
-		// (vm-load (<type>, <waiting>) (input environment))
-		case OP_VM_LOAD: {
-#ifdef INITIAL_ENVIRONMENT
-			int type = vm_state.load.type;
-			bool &waiting = vm_state.load.waiting;
+				// The evaluated arguments are taken directly from the data stack
+				LispNodeRC result = vm_call_operator(input->head->item->number_i, arity, environment);
 
-			if(waiting == false) {
-				if(count_members(input) != 2) {
-					print_error(input, "missing or extra arguments\n");
+				if(result == nullptr) {
+					print_error(input, "evaluation error\n");
 					vm_finish();
 
-					return;
+					VM_NEXT();
 				}
 
-				const LispNodeRC &symbol = input->head->next->item;
+				for(unsigned int i = 0; i < arity; i++) {
+					data_pop();
+				}
 
-				vm_push_operation(OP_VM_EVAL, symbol, environment, VMState::Eval{});
+				vm_pop();
+				data_push(result);
 
-				waiting = true;
+				VM_NEXT();
 			}
-			else {
-				LispNodeRC evaluated_symbol = data_peek();
-				data_pop();
+			// (vm-eval-list (<discard-itermediary> <waiting>) (evaluation_items environment))
+			DISPATCH_CASE(OP_VM_EVAL_LIST) {
+				LispNodeRC &evaluation_items = top->input;
 
-				if(type == OP_LOAD) {
-					int index;
-					const char *value = nullptr;
+				bool discard_intermediary = vm_state->eval_list.discard_intermediary;
+				bool &waiting = vm_state->eval_list.waiting;
 
-					if((index = get_lambda_index(evaluated_symbol->data)) != -1) {
-						value = lambda_strings[index];
-					}
+				if(evaluation_items == list_empty) {
+					// An empty evaluation list does not insert anything into the data stack
+					vm_pop();
 
-					if((index = get_macro_index(evaluated_symbol->data)) != -1) {
-						value = macro_strings[index];
-					}
+					VM_NEXT();
+				}
+
+				// If we are working in a begin operator
+				if(waiting == true && discard_intermediary == true) {
+					data_pop();
+				}
 
-					LispNodeRC load_expression = make3(make_operator(OP_DEFINE), evaluated_symbol, parse_expression(value, false));
+				bool last_item = (evaluation_items->head->next == nullptr);
 
+				// For tail-recursion
+				if(last_item) {
 					vm_pop();
-					vm_push_operation(OP_VM_EVAL, load_expression, environment, VMState::Eval{});
 				}
-				else {
-					LispNodeRC unload_expression = make3(make_operator(OP_SET_E), evaluated_symbol, atom_false);
 
-					vm_pop();
-					vm_push_operation(OP_VM_EVAL, input, environment, VMState::Eval{});
+				vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
+
+				if(last_item) {
+					VM_NEXT();
 				}
+
+				evaluation_items = make_cdr(evaluation_items);
+				waiting = true;
+
+				VM_NEXT();
 			}
-#else
-			print_error("vm-load", "no compiled support\n");
-			vm_finish();
-#endif /* INITIAL_ENVIRONMENT */
+			// (vm-if <waiting> ([test consequent alternative] environment))
+			DISPATCH_CASE(OP_VM_IF) {
+				bool &waiting = vm_state->if_else.waiting;
 
-			return;
-		}
-		// (vm-call <arity> (input environment))
-		case OP_VM_CALL: {
-			unsigned int arity = vm_state.call.arity;
+				if(waiting == false) {
+					unsigned int number_arguments = count_members(input);
+
+					if(number_arguments != 2 && number_arguments != 3) {
+						print_error("if", "missing or extra arguments\n");
+						vm_finish();
 
-			LispNodeRC evaluated_input = list_empty;
+						VM_NEXT();
+					}
+
+					vm_push_operation(OP_VM_EVAL, input->head->item, environment, VMState::Eval{});
+					waiting = true;
 
-			bool is_apply = input->is_operation(OP_APPLY);
+					VM_NEXT();
+				}
 
-			if(is_apply) {
-				evaluated_input = data_peek();
+				LispNodeRC result = data_peek();
 				data_pop();
 
-				if(!evaluated_input->is_list()) {
-					print_error(input, "last argument must be list\n");
-					vm_finish();
+				// As in cond, only #t selects the consequent
+				Box *branch_box = input->get_head_pointer()->get_next_pointer();
 
-					return;
+				if(!(result == atom_true)) {
+					branch_box = branch_box->get_next_pointer();
 				}
-			}
-
-			// If it is an apply operation, we already collected one evaluated input
-			int to_collect = (is_apply ? arity - 1 : arity);
 
-			BoxRC evaluated_parameter_sequence = nullptr;
+				if(branch_box == nullptr) {
+					// No alternative: just evaluate to the empty list
+					vm_pop();
+					data_push(list_empty);
 
-			for(size_t i = 0; i < to_collect; i++) {
-				evaluated_parameter_sequence = new Box(data_peek(), evaluated_parameter_sequence);
-				data_pop();
-			}
+					VM_NEXT();
+				}
 
-			// If it is an apply operation, the first input is the operation and it has
-			// already been added
-			if(is_apply) {
-				evaluated_input = LispNode::make_list(evaluated_parameter_sequence.get_pointer());
+				LispNodeRC branch = branch_box->item;
 
+				// For tail-recursion
 				vm_pop();
-				vm_push_operation(OP_VM_EVAL, evaluated_input, environment, VMState::Eval{});
+				vm_push_operation(OP_VM_EVAL, branch, environment, VMState::Eval{});
 
-				return;
+				VM_NEXT();
 			}
+			// (vm-let (<OP_LET/OP_LET_STAR/OP_LETREC> <waiting> <binding_box>) (input environment))
+			DISPATCH_CASE(OP_VM_LET) {
+				int type = vm_state->let.type;
+				bool &waiting = vm_state->let.waiting;
+				Box *&binding_box = vm_state->let.binding_box;
 
-			// Add the original operator to the front of the evaluated arguments
-			Box *evaluated_input_sequence = new Box(input->head->item, evaluated_parameter_sequence);
-			evaluated_input = LispNode::make_list(evaluated_input_sequence);
+				// The environment extended with the bindings so far
+				LispNodeRC &new_environment = top->extra1;
 
-			LispNodeRC result;
+				if(waiting == false) {
+					if(count_members(input) < 3) {
+						print_error(input, "missing arguments\n");
+						vm_finish();
 
-			switch(arity) {
-				case 0:
-					result = eval_gen0(evaluated_input, environment);
-					break;
-				case 1:
-					result = eval_gen1(evaluated_input, environment);
-					break;
-				case 2:
-					result = eval_gen2(evaluated_input, environment);
-					break;
-				case 3:
-					result = eval_gen3(evaluated_input, environment);
-					break;
-			}
+						VM_NEXT();
+					}
 
-			if(result == nullptr) {
-				print_error(input, "evaluation error\n");
-				vm_finish();
+					const LispNodeRC &bindings = input->head->next->item;
 
-				return;
-			}
+					if(!has_valid_bindings(bindings)) {
+						print_error(input, "argument type error\n");
+						vm_finish();
 
-			vm_pop();
-			data_push(result);
+						VM_NEXT();
+					}
 
-			return;
-		}
-		// (vm-eval-list (<discard-itermediary> <waiting>) (evaluation_items environment))
-		case OP_VM_EVAL_LIST: {
-			LispNodeRC &evaluation_items = top.input;
+					new_environment = environment;
+					binding_box = bindings->get_head_pointer();
 
-			bool discard_intermediary = vm_state.eval_list.discard_intermediary;
-			bool &waiting = vm_state.eval_list.waiting;
+					// Every value of a letrec sees all the names, so they are bound (to '()) up front
+					if(type == OP_LETREC) {
+						for(Box *current_binding_box = binding_box; current_binding_box != nullptr; current_binding_box = current_binding_box->get_next_pointer()) {
+							new_environment = make_cons(make2(current_binding_box->item->head->item, list_empty), new_environment);
+						}
+					}
 
-			if(evaluation_items == list_empty) {
-				// An empty evaluation list does not insert anything into the data stack
-				vm_pop();
+					waiting = true;
+				}
+				else {
+					LispNodeRC value = data_peek();
+					data_pop();
 
-				return;
-			}
+					const LispNodeRC &name = binding_box->item->head->item;
 
-			// If we are working in a begin operator
-			if(waiting == true && discard_intermediary == true) {
-				data_pop();
-			}
+					if(type == OP_LETREC) {
+						make_query_optional_replace(name, new_environment, value);
+					}
+					else {
+						new_environment = make_cons(make2(name, value), new_environment);
+					}
+
+					binding_box = binding_box->get_next_pointer();
+				}
 
-			bool last_item = (evaluation_items->head->next == nullptr);
+				if(binding_box == nullptr) {
+					// The body is a sequence, as in a begin (and in tail position)
+					LispNodeRC body = LispNode::make_list(input->get_head_pointer()->get_next_pointer()->get_next_pointer());
+					LispNodeRC body_environment = new_environment;
 
-			// For tail-recursion
-			if(last_item) {
-				vm_pop();
-			}
+					vm_pop();
+					vm_push_operation(OP_VM_BEGIN, body, body_environment, VMState::Begin{false, nullptr});
 
-			vm_push_operation(OP_VM_EVAL, evaluation_items->head->item, environment, VMState::Eval{});
+					VM_NEXT();
+				}
 
-			if(last_item) {
-				return;
+				// let evaluates every value in the outer environment, let* and letrec in the extended one
+				vm_push_operation(OP_VM_EVAL, binding_box->item->head->next->item, (type == OP_LET ? environment : new_environment), VMState::Eval{});
+
+				VM_NEXT();
 			}
+#ifdef BYTECODE
+			// (vm-code (<ip> <base>) (closure environment))
+			DISPATCH_CASE(OP_VM_CODE) {
+				vm_step_code();
 
-			evaluation_items = make_cdr(evaluation_items);
-			waiting = true;
+				VM_NEXT();
+			}
+#endif /* BYTECODE */
+#if !defined(THREADED_DISPATCH) || !defined(BYTECODE)
+			// With threaded dispatch, only OP_VM_CODE may lack a handler (in builds without bytecode)
+			DISPATCH_DEFAULT {
+				print_integral(top->op);
+				print_error(" at vm_run()", "unknown operation\n");
+				vm_finish();
 
-			return;
+				VM_NEXT();
+			}
+#endif /* !THREADED_DISPATCH || !BYTECODE */
 		}
-		default:
-			print_integral(top.op);
-			print_error(" at vm_step()", "unknown operation\n");
-			vm_finish();
-
-			return;
 	}
 }
 
 LispNodeRC eval_expression(const LispNodeRC input, const LispNodeRC environment) {
 	vm_push_operation(OP_VM_EVAL, input, environment, VMState::Eval{});
 
-	while(vm_top > 0) {
-		if(vm_top >= EVALUATION_STACK_SIZE) {
-			fputs("Eval stack overflow; use tail-recursion\n", stdout);
-
-			return nullptr;
-		}
-
-		if(data_top >= DATA_STACK_SIZE) {
-			fputs("Data stack overflow; use tail-recursion\n", stdout);
-
-			return nullptr;
-		}
-
-		vm_step();
+	if(!vm_run()) {
+		return nullptr;
 	}
 
 	if(data_top == 0) {
@@ -1820,42 +4249,79 @@ LispNodeRC eval_expression(const LispNodeRC input, const LispNodeRC environment)
 }
 
 void cleanup_stacks() {
-	for(unsigned int i = 0; i < vm_maximum; i++) {
+	// Gives back the segments a deep recursion needed, keeping the first one
+	evaluation_stack.shrink(1);
+	data_stack.shrink(1);
+
+	vm_limit = evaluation_stack.capacity() - STACK_SLACK;
+	data_limit = data_stack.capacity() - STACK_SLACK;
+
+	for(unsigned int i = 0; i < evaluation_stack.capacity(); i++) {
 		evaluation_stack[i].input = list_empty;
 		evaluation_stack[i].environment = list_empty;
 		evaluation_stack[i].extra1 = list_empty;
 	}
 
-	for(unsigned int i = 0; i < data_maximum; i++) {
+	for(unsigned int i = 0; i < data_stack.capacity(); i++) {
 		data_stack[i] = list_empty;
 	}
 }
 
-void cleanup() {
+// Objects deleted between top-level expressions (the rest are deleted along with later allocations)
+#ifdef TARGET_6502
+constexpr size_t CLEANUP_DELETION_BUDGET = 1024;
+#else
+constexpr size_t CLEANUP_DELETION_BUDGET = 65536;
+#endif /* TARGET_6502 */
+
+void cleanup(bool finishing = false) {
 #ifdef TARGET_6502
 		fputs(";* cleaning up... ", stdout);
 #endif /* TARGET_6502 */
 
+	size_t budget = (finishing ? SIZE_MAX : CLEANUP_DELETION_BUDGET);
+
 	// Round 1: pre VM/data stack cleaning
-	while(Allocator<LispNode>::process_deletions() == true || Allocator<Box>::process_deletions() == true) {
+	while(Allocator<LispNode>::process_deletions(budget) == true || Allocator<Box>::process_deletions(budget) == true) {
 		// Keep cleaning...
 	}
 
 	cleanup_stacks();
 
 	// Round 2: post VM/data stack cleaning
-	while(Allocator<LispNode>::process_deletions() == true || Allocator<Box>::process_deletions() == true) {
+	while(Allocator<LispNode>::process_deletions(budget) == true || Allocator<Box>::process_deletions(budget) == true) {
 		// Keep cleaning...
 	}
 
+#ifdef CYCLE_COLLECTOR
+	// Frees what only references itself, such as closures in the environments they capture (when
+	// finishing, what is freed makes more candidates, so it goes on until there are none left)
+	while(finishing ? CycleCollector::number_candidates > 0 : CycleCollector::is_due()) {
+		CycleCollector::collect();
+
+		while(Allocator<LispNode>::process_deletions(budget) == true || Allocator<Box>::process_deletions(budget) == true) {
+			// Keep cleaning...
+		}
+	}
+#endif /* CYCLE_COLLECTOR */
+
+#ifdef MARK_AND_SWEEP
+	// Nothing in the stacks is live between top-level expressions
+	vm_finish();
+
+	if(GarbageCollector::is_due()) {
+		collect_garbage();
+	}
+#endif /* MARK_AND_SWEEP */
+
 #ifdef TARGET_6502
 		fputs("done\n", stdout);
 #endif /* TARGET_6502 */
 }
 
 void initialize_stacks() {
-	vm_maximum = EVALUATION_STACK_SIZE + 4;
-	data_maximum = DATA_STACK_SIZE + 4;
+	evaluation_stack.init(STACK_SEGMENTS);
+	data_stack.init(STACK_SEGMENTS);
 
 	cleanup_stacks();
 }
@@ -1865,33 +4331,47 @@ int main(int argc, char **argv) {
 	__set_heap_limit(LISP_HEAP_SIZE);
 #endif /* TARGET_6502 */
 
+#ifdef GENERATIONAL
+	// Reserves the nursery and the old generation
+	SimpleAllocator::init();
+#endif /* GENERATIONAL */
+
 	// Initializes the allocator managers for LispNode and Box
 	Allocator<LispNode>::init();
 	Allocator<Box>::init();
 
+	// Initializes the symbol table used to intern pure atoms
+	SymbolTable::init();
+
 	// Setup global constants
 
-	atom_true = new LispNode(LispType::AtomBoolean);
+	LispNode::init();
+
+	atom_true = LispNode::make_immortal(LispType::AtomBoolean);
 	atom_true->data = strdup("#t");
 
-	atom_false = new LispNode(LispType::AtomBoolean);
+	atom_false = LispNode::make_immortal(LispType::AtomBoolean);
 	atom_false->data = strdup("#f");
 
-	list_empty = new LispNode(LispType::List);
+	list_empty = LispNode::make_immortal(LispType::List);
 	list_empty->head = nullptr;
 
+	symbol_dot = LispNode::make_symbol(".");
+
+	// Kept apart from the shared lambda operator, as resolved lambdas are told apart by this node
+	operator_lambda_resolved = LispNode::make_immortal(LispType::AtomOperator);
+	operator_lambda_resolved->number_i = OP_LAMBDA;
+
 	// Setup global environment
 
 	global_environment = list_empty;
 
-	// Setup VM (4 entries extra so we check overflow only occasionally on vm_step())
-	evaluation_stack = new VMStackFrame[EVALUATION_STACK_SIZE + 4];
-	data_stack = new LispNodeRC[DATA_STACK_SIZE + 4];
-
-	// Read-Eval-Print loop
+	// Setup VM
 
 	initialize_stacks();
 
+	// Read-Eval-Print loop
+
 	while(true) {
 		vm_reset();
 
@@ -1956,9 +4436,13 @@ int main(int argc, char **argv) {
 	atom_true = nullptr;
 	atom_false = nullptr;
 	list_empty = nullptr;
+	symbol_dot = nullptr;
+	operator_lambda_resolved = nullptr;
 	global_environment = nullptr;
 
-	cleanup();
+	SymbolTable::finish();
+
+	cleanup(true);
 	vm_finish();
 
 	return EXIT_SUCCESS;
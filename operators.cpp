@@ -32,6 +32,40 @@ const char *operator_names[] = {
     "string->data",
     "data->string",
 
+    // String support
+    "string-length",
+    "string-ref",
+    "string-set!",
+    "string-append",
+    "substring",
+    "make-string",
+    "list->string",
+    "string->list",
+    "string=?",
+    "string<?",
+    "string-index",
+
+    // Vector support
+    "vector?",
+    "make-vector",
+    "vector-ref",
+    "vector-set!",
+    "vector-length",
+    "vector->list",
+    "list->vector",
+
+    // Hash table support
+    "make-hash-table",
+    "hash-table?",
+    "hash-table-ref",
+    "hash-table-ref/default",
+    "hash-table-set!",
+    "hash-table-delete!",
+    "hash-table-contains?",
+    "hash-table-count",
+    "hash-table-keys",
+    "hash-table->alist",
+
     // Display support
     "display",
     "newline",
@@ -49,11 +83,28 @@ const char *operator_names[] = {
     "<=",
     ">=",
 
+    // Integer support
+    "quotient",
+    "remainder",
+    "modulo",
+    "bitwise-and",
+    "bitwise-or",
+    "bitwise-xor",
+    "bitwise-not",
+    "arithmetic-shift",
+    "bit-count",
+
     // Logic
     "and",
     "or",
     "not",
 
+    // Scope and control
+    "if",
+    "let",
+    "let*",
+    "letrec",
+
     // Environment and Lambda support
     "begin",
     "define",
@@ -91,7 +142,10 @@ const char *operator_names[] = {
     "vm-eval",
     "vm-load",
     "vm-call",
-    "vm-eval-list"
+    "vm-eval-list",
+    "vm-if",
+    "vm-let",
+    "vm-code"
 };
 
 ReduceMode operator_reduce_modes[] = {
@@ -126,33 +180,84 @@ ReduceMode operator_reduce_modes[] = {
     Normal1,
     Normal1,
 
-    // Display support
+    // String support
     Normal1,
-    Normal0,
+    Normal2,
+    Normal3,
+    Normal2,
+    Normal3,
+    Normal2,
+    Normal1,
+    Normal1,
+    Normal2,
+    Normal2,
+    Normal2,
 
-    // Arithmetic
+    // Vector support
+    Normal1,
     Normal2,
     Normal2,
+    Normal3,
+    Normal1,
+    Normal1,
+    Normal1,
+
+    // Hash table support
+    Normal0,
+    Normal1,
+    Normal2,
+    Normal3,
+    Normal3,
     Normal2,
     Normal2,
+    Normal1,
+    Normal1,
+    Normal1,
+
+    // Display support
+    Normal1,
+    Normal0,
+
+    // Arithmetic
+    NormalX,
+    NormalX,
+    NormalX,
+    NormalX,
 
     // Arithmetic comparison
+    NormalX,
+    NormalX,
+    NormalX,
+    NormalX,
+    NormalX,
+
+    // Integer support
+    Normal2,
+    Normal2,
     Normal2,
     Normal2,
     Normal2,
     Normal2,
+    Normal1,
     Normal2,
+    Normal1,
 
     // Logic
     SpecialLogic,
     SpecialLogic,
     Normal1,
 
+    // Scope and control
+    SpecialIf,
+    SpecialLet,
+    SpecialLet,
+    SpecialLet,
+
     // Environment and Lambda support
     SpecialBegin,
     SpecialDefine,
     SpecialDefine,
-    SpecialEval,
+    NormalX,
     ImmediateLambda,
     ImmediateMacro,
     ImmediateClosure,
@@ -185,5 +290,8 @@ ReduceMode operator_reduce_modes[] = {
     VM,
     VM,
     VM,
+    VM,
+    VM,
+    VM,
     VM
 };
\ No newline at end of file
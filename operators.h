@@ -32,6 +32,37 @@ enum LispOperation {
     OP_STRING_DATA,
     OP_DATA_STRING,
 
+    OP_STRING_LENGTH,
+    OP_STRING_REF,
+    OP_STRING_SET_E,
+    OP_STRING_APPEND,
+    OP_SUBSTRING,
+    OP_MAKE_STRING,
+    OP_LIST_STRING,
+    OP_STRING_LIST,
+    OP_STRING_EQUAL_Q,
+    OP_STRING_LESS_Q,
+    OP_STRING_INDEX,
+
+    OP_VECTOR_Q,
+    OP_MAKE_VECTOR,
+    OP_VECTOR_REF,
+    OP_VECTOR_SET_E,
+    OP_VECTOR_LENGTH,
+    OP_VECTOR_LIST,
+    OP_LIST_VECTOR,
+
+    OP_MAKE_HASH_TABLE,
+    OP_HASH_TABLE_Q,
+    OP_HASH_TABLE_REF,
+    OP_HASH_TABLE_REF_DEFAULT,
+    OP_HASH_TABLE_SET_E,
+    OP_HASH_TABLE_DELETE_E,
+    OP_HASH_TABLE_CONTAINS_Q,
+    OP_HASH_TABLE_COUNT,
+    OP_HASH_TABLE_KEYS,
+    OP_HASH_TABLE_ALIST,
+
     OP_DISPLAY,
     OP_NEWLINE,
 
@@ -46,10 +77,25 @@ enum LispOperation {
     OP_LESS_EQUAL,
     OP_BIGGER_EQUAL,
 
+    OP_QUOTIENT,
+    OP_REMAINDER,
+    OP_MODULO,
+    OP_BITWISE_AND,
+    OP_BITWISE_OR,
+    OP_BITWISE_XOR,
+    OP_BITWISE_NOT,
+    OP_ARITHMETIC_SHIFT,
+    OP_BIT_COUNT,
+
     OP_AND,
     OP_OR,
     OP_NOT,
 
+    OP_IF,
+    OP_LET,
+    OP_LET_STAR,
+    OP_LETREC,
+
     OP_BEGIN,
     OP_DEFINE,
     OP_SET_E,
@@ -83,18 +129,22 @@ enum LispOperation {
     OP_VM_EVAL,
     OP_VM_LOAD,
     OP_VM_CALL,
-    OP_VM_EVAL_LIST
+    OP_VM_EVAL_LIST,
+    OP_VM_IF,
+    OP_VM_LET,
+    OP_VM_CODE
 };
 
-constexpr int NUMBER_BASIC_OPERATORS = OP_VM_EVAL_LIST + 1;
+constexpr int NUMBER_BASIC_OPERATORS = OP_VM_CODE + 1;
 
 enum ReduceMode : unsigned char {
     SpecialQuote,
     SpecialCond,
     SpecialLogic,
     SpecialBegin,
+    SpecialIf,
+    SpecialLet,
     SpecialDefine,
-    SpecialEval,
     SpecialLoad,
     Normal0,
     Normal1,
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Redefines a recursive function many times, within a fixed amount of memory: each redefinition
+# drops a closure, so memory only stays flat if the dropped closures are freed
+#
+# For builds without DEBUG or GENERATIONAL (the address sanitizer and the old generation
+# reserve far more address space)
+
+LISPIRITO=${1:-./lispirito}
+MEMORY_LIMIT_KB=32768
+
+ulimit -v $MEMORY_LIMIT_KB
+
+awk 'BEGIN { for(i = 0; i < 300000; i++) print "(define (f x) (if (= x 0) 0 (f (- x 1))))"; print "(f 1000)" }' | "$LISPIRITO" > /dev/null 2>&1
+
+if [ $? -ne 0 ]; then
+    echo "FAILED: redefinitions did not run within $MEMORY_LIMIT_KB KB"
+    exit 1
+fi
+
+echo "OK: redefinitions ran within $MEMORY_LIMIT_KB KB"
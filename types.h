@@ -5,15 +5,26 @@
     #include <fixed_point.h>
 
     using Integral = int32_t;
+    using UnsignedIntegral = uint32_t;
     using Real = FixedPoint<22, 10>;
 
+    // Decimal digits that always fit an Integral
+    constexpr unsigned int INTEGRAL_DIGITS = 9;
+
     // Make this be floor(log_{10}(2^x)) where x is the number of decimal points
     constexpr int DECIMAL_RESOLUTION = 3;
 #else
     using Integral = long;
+    using UnsignedIntegral = unsigned long;
     using Real = double;
+
+    // Decimal digits that always fit an Integral
+    constexpr unsigned int INTEGRAL_DIGITS = (sizeof(Integral) >= 8 ? 18 : 9);
 #endif /* TARGET_6502 */
 
+constexpr Integral INTEGRAL_MAXIMUM = static_cast<Integral>(static_cast<UnsignedIntegral>(-1) >> 1);
+constexpr Integral INTEGRAL_MINIMUM = -INTEGRAL_MAXIMUM - 1;
+
 using CounterType = unsigned int;
 
 #endif /* TYPES_H */
\ No newline at end of file